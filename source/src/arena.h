@@ -0,0 +1,117 @@
+#pragma once
+
+#include "vector.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+class MonotonicArena {
+
+	public:
+
+		// --- Constructors ---
+
+		explicit MonotonicArena(size_t block_size = 64 * 1024)
+			: block_size_(block_size == 0 ? 1 : block_size)
+		{}
+
+		MonotonicArena(const MonotonicArena&) = delete;
+		MonotonicArena& operator=(const MonotonicArena&) = delete;
+
+		// --- Arena functions ---
+
+		void* Allocate(size_t bytes, size_t alignment = alignof(std::max_align_t)) {	// Bump the pointer inside the current block
+			assert(alignment != 0 && (alignment & (alignment - 1)) == 0);					// alignment must be a power of two
+			if (void* result = TryBump(bytes, alignment)) { return result; }
+
+			while (current_ + 1 < blocks_.Size()) {			// blocks kept by Reset are reused in order
+				SelectBlock(current_ + 1);
+				if (void* result = TryBump(bytes, alignment)) { return result; }
+			}
+
+			RawMemory<unsigned char> block(std::max(block_size_, bytes + alignment));	// oversized requests get a block of their own
+			blocks_.PushBack(std::move(block));
+			allocated_ += blocks_[blocks_.Size() - 1].Capacity();
+			SelectBlock(blocks_.Size() - 1);
+			return TryBump(bytes, alignment);
+		}
+
+		void Reset() noexcept {		// Drop every allocation at once, blocks are kept for reuse
+			used_ = 0;
+			if (blocks_.Size() != 0) { SelectBlock(0); }
+		}
+
+		void Release() noexcept {	// Drop every allocation and return all blocks
+			Vector<RawMemory<unsigned char>> empty;
+			blocks_.Swap(empty);
+			current_ = 0;
+			ptr_ = nullptr;
+			end_ = nullptr;
+			allocated_ = 0;
+			used_ = 0;
+		}
+
+		size_t BytesAllocated() const noexcept { return allocated_; }	// Total size of all blocks
+		size_t BytesUsed()      const noexcept { return used_; }		// Bytes handed out since the last Reset, including alignment padding
+
+	private:
+
+		void* TryBump(size_t bytes, size_t alignment) noexcept {
+			uintptr_t address = reinterpret_cast<uintptr_t>(ptr_);
+			uintptr_t aligned = (address + alignment - 1) & ~(alignment - 1);
+			if (ptr_ == nullptr || aligned + bytes > reinterpret_cast<uintptr_t>(end_)) { return nullptr; }
+			unsigned char* result = ptr_ + (aligned - address);
+			used_ += (aligned - address) + bytes;
+			ptr_ = result + bytes;
+			return result;
+		}
+
+		void SelectBlock(size_t index) noexcept {
+			current_ = index;
+			ptr_ = blocks_[index].GetAddress();
+			end_ = ptr_ + blocks_[index].Capacity();
+		}
+
+		Vector<RawMemory<unsigned char>> blocks_;	// Allocated raw memory
+		size_t block_size_;
+		size_t current_ = 0;						// Index of the block being bumped
+		unsigned char* ptr_ = nullptr;				// Next free byte in the current block
+		unsigned char* end_ = nullptr;				// End of the current block
+		size_t allocated_ = 0;
+		size_t used_ = 0;
+};
+
+template <typename T>
+class ArenaAllocator {	// Allocator for Vector and RawMemory, deallocation is a no-op until the arena is reset
+
+	public:
+
+		using value_type = T;
+
+		// --- Constructors ---
+
+		ArenaAllocator(MonotonicArena& arena) noexcept : arena_(&arena) {}
+
+		template <typename U>
+		ArenaAllocator(const ArenaAllocator<U>& other) noexcept : arena_(&other.GetArena()) {}
+
+		// --- Allocator functions ---
+
+		T* allocate(size_t n) { return static_cast<T*>(arena_->Allocate(n * sizeof(T), alignof(T))); }
+		void deallocate(T*, size_t) noexcept {}
+
+		MonotonicArena& GetArena() const noexcept { return *arena_; }
+
+		template <typename U>
+		bool operator==(const ArenaAllocator<U>& other) const noexcept { return arena_ == &other.GetArena(); }
+		template <typename U>
+		bool operator!=(const ArenaAllocator<U>& other) const noexcept { return !(*this == other); }
+
+	private:
+
+		MonotonicArena* arena_;
+};
+
+template <typename T>
+using ArenaVector = Vector<T, ArenaAllocator<T>>;
@@ -0,0 +1,5 @@
+#pragma once
+
+#include <cstddef>
+
+inline constexpr size_t CACHE_LINE_SIZE = 64;	// Padding unit that keeps indices written by different threads on separate lines
@@ -0,0 +1,146 @@
+#pragma once
+
+#include "vector.h"
+
+#include <atomic>
+#include <type_traits>
+#include <utility>
+
+template <typename T, bool AtomicRefCount = false>
+class CowVector {	// Copies share one buffer, the first mutation of a shared buffer duplicates it
+
+	using RefCount = std::conditional_t<AtomicRefCount, std::atomic<size_t>, size_t>;	// atomic only when copies cross threads
+
+	struct Block {
+		template <typename... Args>
+		explicit Block(Args&&... args) : elements(std::forward<Args>(args)...) {}
+
+		RefCount refs{ 1 };
+		Vector<T> elements;
+	};
+
+	public:
+
+		// --- Constructors ---
+
+		CowVector() = default;
+
+		explicit CowVector(size_t size)
+			: block_(new Block(size))
+		{}
+
+		explicit CowVector(Vector<T> elements)
+			: block_(new Block(std::move(elements)))
+		{}
+
+		CowVector(const CowVector& other) noexcept	// O(1) - shares the buffer
+			: block_(other.block_)
+		{
+			AddRef();
+		}
+
+		CowVector(CowVector&& other) noexcept
+			: block_(std::exchange(other.block_, nullptr))
+		{}
+
+		// --- Destructor ---
+
+		~CowVector() { Release(); }
+
+		// --- Operators overloads ---
+
+		const T& operator[](size_t index) const noexcept { assert(block_ != nullptr); return block_->elements[index]; }	// Reading never copies
+
+		CowVector& operator=(const CowVector& rhs) noexcept {
+			if (block_ != rhs.block_) {		// checking for self-assignment and for an already shared buffer
+				CowVector rhs_copy(rhs);
+				Swap(rhs_copy);
+			}
+			return *this;
+		}
+
+		CowVector& operator=(CowVector&& rhs) noexcept {
+			if (this != &rhs) { Swap(rhs); }	// checking for self-assignment, swap
+			return *this;
+		}
+
+		// --- "std::vector"-like functions ---
+
+		size_t Size()     const noexcept { return block_ == nullptr ? 0 : block_->elements.Size(); }
+		size_t Capacity() const noexcept { return block_ == nullptr ? 0 : block_->elements.Capacity(); }
+
+		bool IsShared() const noexcept { return UseCount() > 1; }
+		size_t UseCount() const noexcept {
+			if (block_ == nullptr) { return 0; }
+			if constexpr (AtomicRefCount) { return block_->refs.load(std::memory_order_acquire); }
+			else                          { return block_->refs; }
+		}
+
+		void Swap(CowVector& other) noexcept { std::swap(block_, other.block_); }
+
+		// The references that MutableAt and Detach return point into a buffer that is exclusive only until the next copy of
+		// this CowVector: a copy shares the buffer again, and a write through an older reference would change both.
+		// Take a fresh reference after every copy, or mutate inside Update, whose reference cannot outlive the call.
+
+		T& MutableAt(size_t index) { return Detach()[index]; }	// Copies the buffer first if it is shared
+
+		template <typename Function>
+		decltype(auto) Update(Function&& function) { return std::forward<Function>(function)(Detach()); }	// Scoped batch of writes, one detach
+
+		void Reserve(size_t new_capacity) { Detach().Reserve(new_capacity); }
+		void Resize(size_t new_size)      { Detach().Resize(new_size); }
+
+		template <typename Type>
+		void PushBack(Type&& value) { EmplaceBack(std::forward<Type>(value)); }
+
+		template <typename... Args>
+		T& EmplaceBack(Args&&... args) {
+			if (IsShared()) {
+				T value(std::forward<Args>(args)...);	// args may refer to the shared buffer about to be released
+				return Detach().EmplaceBack(std::move(value));
+			}
+			return Detach().EmplaceBack(std::forward<Args>(args)...);
+		}
+
+		void PopBack() {
+			if (Size() > 0) { Detach().PopBack(); }
+		}
+
+		Vector<T>& Detach() {	// Make the buffer exclusively owned and return it for in-place mutation
+			if (block_ == nullptr) {
+				block_ = new Block();
+			}
+			else if (IsShared()) {
+				Block* copy = new Block(block_->elements);	// uninitialized_copy_n happens here, on the first write only
+				Release();
+				block_ = copy;
+			}
+			return block_->elements;
+		}
+
+		// --- Iterators (const only, mutation goes through Detach) ---
+
+		const T* begin()  const noexcept { return block_ == nullptr ? nullptr : block_->elements.begin(); }
+		const T* end()    const noexcept { return block_ == nullptr ? nullptr : block_->elements.end()  ; }
+		const T* cbegin() const noexcept { return begin(); }
+		const T* cend()   const noexcept { return end()  ; }
+
+	private:
+
+		void AddRef() noexcept {
+			if (block_ == nullptr) { return; }
+			if constexpr (AtomicRefCount) { block_->refs.fetch_add(1, std::memory_order_relaxed); }
+			else                          { ++block_->refs; }
+		}
+
+		void Release() noexcept {
+			if (block_ == nullptr) { return; }
+			bool last = false;
+			if constexpr (AtomicRefCount) { last = block_->refs.fetch_sub(1, std::memory_order_acq_rel) == 1; }
+			else                          { last = --block_->refs == 0; }
+			if (last) { delete block_; }
+			block_ = nullptr;
+		}
+
+		Block* block_ = nullptr;	// nullptr for an empty vector without a buffer
+};
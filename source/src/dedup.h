@@ -0,0 +1,140 @@
+#pragma once
+
+#include "vector.h"
+#include "hash.h"
+#include "merge.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+// Duplicate removal that compacts in place and then drops the tail with one Truncate, so every
+// removed element is destroyed exactly once and nothing is shifted more than once. Integral
+// vectors are sorted with an LSD radix sort, skipping the byte passes in which all keys agree.
+
+namespace dedup_detail {
+
+	inline constexpr size_t RADIX_MIN_SIZE = 256;			// Below this std::sort wins
+	inline constexpr size_t PARALLEL_MIN_SIZE = 1 << 16;
+
+	template <typename T>
+	inline constexpr bool IS_RADIX_KEY = std::is_integral_v<T> && !std::is_same_v<T, bool>;
+
+	template <typename T>
+	auto RadixKey(T value) noexcept {		// Unsigned key with the same order, signed values get their sign bit flipped
+		using Unsigned = std::make_unsigned_t<T>;
+		Unsigned key = static_cast<Unsigned>(value);
+		if constexpr (std::is_signed_v<T>) { key ^= Unsigned{ 1 } << (std::numeric_limits<Unsigned>::digits - 1); }
+		return key;
+	}
+
+	template <typename T>
+	void RadixSort(Span<T> data, Span<T> buffer) {		// buffer - scratch of the same size
+		T* from = data.GetAddress();
+		T* to = buffer.GetAddress();
+		size_t size = data.Size();
+		if (size == 0) { return; }
+		for (size_t shift = 0; shift < sizeof(T) * 8; shift += 8) {
+			size_t counts[256] = {};
+			for (size_t i = 0; i < size; ++i) { ++counts[(RadixKey(from[i]) >> shift) & 0xFF]; }
+			if (counts[(RadixKey(from[0]) >> shift) & 0xFF] == size) { continue; }	// every key has this byte, the pass would only copy
+			size_t offset = 0;
+			for (size_t& count : counts) {
+				size_t bucket = count;
+				count = offset;
+				offset += bucket;
+			}
+			for (size_t i = 0; i < size; ++i) { to[counts[(RadixKey(from[i]) >> shift) & 0xFF]++] = from[i]; }
+			std::swap(from, to);
+		}
+		if (from != data.GetAddress()) { std::copy_n(from, size, data.GetAddress()); }
+	}
+
+	template <typename T>
+	void Sort(Span<T> data) {
+		if constexpr (IS_RADIX_KEY<T>) {
+			if (data.Size() >= RADIX_MIN_SIZE) {
+				Vector<T> buffer(data.Size());
+				RadixSort(data, buffer.AsSpan());
+				return;
+			}
+		}
+		std::sort(data.begin(), data.end());
+	}
+
+	template <typename T, typename Equal>
+	size_t Unique(Span<T> data, Equal& equal) {		// Compacts adjacent runs to their first element, returns the new size
+		return static_cast<size_t>(std::unique(data.begin(), data.end(), equal) - data.begin());
+	}
+
+}  // namespace dedup_detail
+
+template <typename T, typename Allocator, typename Equal = std::equal_to<>>
+void Dedup(Vector<T, Allocator>& vector, Equal equal = Equal()) {	// Sorted (or grouped) input - keeps the first of every run of equal elements
+	vector.Truncate(dedup_detail::Unique(vector.AsSpan(), equal));
+}
+
+template <typename T, typename Allocator, typename Hash = std::hash<T>, typename Equal = std::equal_to<>>
+void DedupUnsorted(Vector<T, Allocator>& vector, Hash hash = Hash(), Equal equal = Equal()) {	// Keeps first occurrences in their original order
+	size_t size = vector.Size();
+	size_t capacity = 16;
+	while (capacity < size * 2) { capacity *= 2; }		// load factor at most 1/2
+	Vector<size_t> slots(capacity);						// kept position + 1, 0 - empty; the table never copies a T
+	size_t mask = capacity - 1;
+	size_t kept = 0;
+	for (size_t i = 0; i < size; ++i) {
+		size_t slot = static_cast<size_t>(HashCombine(0, hash(vector[i]))) & mask;
+		bool duplicate = false;
+		for (; slots[slot] != 0; slot = (slot + 1) & mask) {
+			if (equal(vector[slots[slot] - 1], vector[i])) {
+				duplicate = true;
+				break;
+			}
+		}
+		if (duplicate) { continue; }
+		if (kept != i) { vector[kept] = std::move(vector[i]); }
+		slots[slot] = ++kept;
+	}
+	vector.Truncate(kept);
+}
+
+template <typename T, typename Allocator>
+void SortDedup(Vector<T, Allocator>& vector) {		// Sorted set of the elements - radix sort for integral T
+	dedup_detail::Sort(vector.AsSpan());
+	Dedup(vector);
+}
+
+template <typename T, typename Allocator>
+void ParallelSortDedup(Vector<T, Allocator>& vector, ThreadPool& pool = ThreadPool::Shared()) {
+	// Every task moves its chunk out and sort-dedups it, the chunks are merged back in parallel and deduplicated once more
+	size_t size = vector.Size();
+	if (size < dedup_detail::PARALLEL_MIN_SIZE) {
+		SortDedup(vector);
+		return;
+	}
+	size_t chunks = (pool.ThreadCount() + 1) * parallel_detail::TASKS_PER_THREAD;
+	Vector<Vector<T, Allocator>> partials;
+	partials.Reserve(chunks);
+	for (size_t chunk = 0; chunk < chunks; ++chunk) {	// allocated here, on one thread - an arena behind vector is not thread-safe
+		partials.EmplaceBack(vector.GetAllocator());
+		partials[chunk].Reserve(size * (chunk + 1) / chunks - size * chunk / chunks);
+	}
+	ParallelFor(chunks, [&](size_t first, size_t last) {
+		for (size_t chunk = first; chunk < last; ++chunk) {
+			size_t begin = size * chunk / chunks;
+			size_t end = size * (chunk + 1) / chunks;
+			Vector<T, Allocator>& partial = partials[chunk];
+			for (size_t i = begin; i < end; ++i) { partial.PushBack(std::move(vector[i])); }
+			SortDedup(partial);
+		}
+	}, 1, pool);
+
+	size_t total = 0;
+	for (const Vector<T, Allocator>& partial : partials) { total += partial.Size(); }
+	ParallelMergeSorted(std::as_const(partials).AsSpan(), vector.Subspan(0, total), std::less<>(), pool);
+	vector.Truncate(total);
+	Dedup(vector);
+}
@@ -0,0 +1,246 @@
+#pragma once
+
+#include "vector.h"
+
+#include <algorithm>
+
+template <typename T>
+class Devector {
+
+	public:
+
+		// --- Constructors ---
+
+		Devector() = default;
+
+		explicit Devector(size_t size)
+			: data_(size)
+			, size_(size)
+		{
+			std::uninitialized_value_construct_n(	// Constructs n objects in the uninitialized storage starting at first by value-initialization
+				data_.GetAddress(),					// uninitialized storage
+				size);								// n objects
+		}
+
+		Devector(const Devector& other)
+			: data_(other.size_)
+			, size_(other.size_)
+		{
+			std::uninitialized_copy_n(other.begin(), size_, data_.GetAddress());
+		}
+
+		Devector(Devector&& other) noexcept { Swap(other); }
+
+		// --- Destructor ---
+
+		~Devector() { std::destroy_n(begin(), size_); }
+
+		// --- Operators overloads ---
+
+		const T& operator[](size_t index) const noexcept { return const_cast<Devector&>(*this)[index]; }			// Constancy trick to avoid duplication of assert
+			  T& operator[](size_t index)       noexcept { assert(index < size_); return data_[front_ + index]; }
+
+		Devector& operator=(const Devector& rhs) {
+			if (this != &rhs) {			// checking for self-assignment
+				Devector rhs_copy(rhs);	// copy-and-swap
+				Swap(rhs_copy);
+			}
+			return *this;
+		}
+
+		Devector& operator=(Devector&& rhs) noexcept {
+			if (this != &rhs) { Swap(rhs); }	// checking for self-assignment, swap
+			return *this;
+		}
+
+		// --- "std::vector"-like functions ---
+
+		size_t Size()          const noexcept { return size_; }
+		size_t Capacity()      const noexcept { return data_.Capacity(); }
+		size_t FrontCapacity() const noexcept { return front_; }							// Free slots before the first element
+		size_t BackCapacity()  const noexcept { return Capacity() - front_ - size_; }	// Free slots after the last element
+
+		void Reserve(size_t new_capacity) {		// Reallocate and center the elements, spare capacity is split between both ends
+			if (new_capacity <= Capacity()) { return; }
+			RawMemory<T> new_data(new_capacity);
+			size_t new_front = (new_capacity - size_) / 2;
+			Relocate(begin(), size_, new_data.GetAddress() + new_front);
+			std::destroy_n(begin(), size_);
+			data_.Swap(new_data);
+			front_ = new_front;
+		}
+
+		void Swap(Devector& other) noexcept {
+			data_.Swap(other.data_);
+			std::swap(front_, other.front_);
+			std::swap(size_, other.size_);
+		}
+
+		void Resize(size_t new_size) {
+			if (new_size > size_) {
+				if (new_size - size_ > BackCapacity()) {	// always grows - the elements may sit at the back of a buffer that is large enough in total
+					Reserve(std::max(Capacity() * 2, new_size * 2));		// centered, leaves at least new_size - size_ at the back
+				}
+				assert(BackCapacity() >= new_size - size_);
+				std::uninitialized_value_construct_n(end(), new_size - size_);
+			}
+			else {
+				std::destroy_n(begin() + new_size, size_ - new_size);
+			}
+			size_ = new_size;
+		}
+
+		void Clear() noexcept {
+			std::destroy_n(begin(), size_);
+			front_ = Capacity() / 2;	// recenter so that both ends get spare capacity again
+			size_ = 0;
+		}
+
+		template <typename Type>
+		void PushBack(Type&& value) { EmplaceBack(std::forward<Type>(value)); }
+
+		template <typename Type>
+		void PushFront(Type&& value) { EmplaceFront(std::forward<Type>(value)); }
+
+		void PopBack() {
+			if (size_ > 0) {
+				std::destroy_at(end() - 1);
+				--size_;
+			}
+		}
+
+		void PopFront() {
+			if (size_ > 0) {
+				std::destroy_at(begin());
+				++front_;
+				--size_;
+			}
+		}
+
+		template <typename... Args>
+		T& EmplaceBack(Args&&... args) {
+			if (BackCapacity() == 0) { return *ReallocateEmplace(size_, std::forward<Args>(args)...); }
+			T* result = new (end()) T(std::forward<Args>(args)...);
+			++size_;
+			return *result;
+		}
+
+		template <typename... Args>
+		T& EmplaceFront(Args&&... args) {
+			if (front_ == 0) { return *ReallocateEmplace(0, std::forward<Args>(args)...); }
+			T* result = new (begin() - 1) T(std::forward<Args>(args)...);
+			--front_;
+			++size_;
+			return *result;
+		}
+
+		template <typename... Args>
+		T* Emplace(const T* pos, Args&&... args) {		// Shifts toward the nearer end that has spare capacity
+			size_t offset = pos - begin();
+			assert(offset <= size_);
+			if (offset == size_) { return &EmplaceBack(std::forward<Args>(args)...); }
+			if (offset == 0)     { return &EmplaceFront(std::forward<Args>(args)...); }
+
+			bool prefer_front = offset < size_ / 2;
+			bool use_front = front_ > 0 && (prefer_front || BackCapacity() == 0);
+			bool use_back = BackCapacity() > 0 && !use_front;
+			if (!use_front && !use_back) { return ReallocateEmplace(offset, std::forward<Args>(args)...); }
+
+			T value(std::forward<Args>(args)...);	// args may refer to an element that is about to be shifted
+			if (use_front) {
+				new (begin() - 1) T(std::move(*begin()));
+				--front_;
+				++size_;
+				std::move(					// Moves the elements in the range [first, last), to another range beginning at d_first
+					begin() + 2,			// first
+					begin() + offset + 1,	// last
+					begin() + 1				// beginning at d_first
+				);
+			}
+			else {
+				new (end()) T(std::move(*(end() - 1)));
+				++size_;
+				std::move_backward(			// Moves the elements from the range [first, last), to another range ending at d_last
+					begin() + offset,		// first
+					end() - 2,				// last
+					end() - 1				// range ending at d_last
+				);
+			}
+			T* result = begin() + offset;
+			*result = std::move(value);
+			return result;
+		}
+
+		T* Insert(const T* pos, const T& value) { return Emplace(pos, value)           ; }
+		T* Insert(const T* pos, T&& value     ) { return Emplace(pos, std::move(value)); }
+
+		T* Erase(const T* pos) {	// Closes the hole from the nearer end
+			size_t offset = pos - begin();
+			assert(offset < size_);
+			if (offset < size_ / 2) {
+				std::move_backward(begin(), begin() + offset, begin() + offset + 1);
+				PopFront();
+			}
+			else {
+				std::move(begin() + offset + 1, end(), begin() + offset);
+				PopBack();
+			}
+			return begin() + offset;
+		}
+
+		// --- Iterators ---
+
+		T* begin() noexcept { return data_.GetAddress() + front_        ; }
+		T* end()   noexcept { return data_.GetAddress() + front_ + size_; }
+
+		const T* begin()  const noexcept { return data_.GetAddress() + front_        ; }
+		const T* end()    const noexcept { return data_.GetAddress() + front_ + size_; }
+		const T* cbegin() const noexcept { return begin()                            ; }
+		const T* cend()   const noexcept { return end()                              ; }
+
+	private:
+
+		static void Relocate(T* from, size_t count, T* to) {	// Move elements unless their move constructor throws and they can be copied
+			if constexpr (std::is_nothrow_move_constructible_v<T> || !std::is_copy_constructible_v<T>) {
+				std::uninitialized_move_n(from, count, to);
+			}
+			else {
+				std::uninitialized_copy_n(from, count, to);
+			}
+		}
+
+		template <typename... Args>
+		T* ReallocateEmplace(size_t offset, Args&&... args) {	// Grow, construct the new element at offset and center everything
+			int size_factor = 2;	// raw memory increase factor like in Vector
+			size_t new_capacity = size_ == 0 ? 2 : size_ * size_factor + 1;
+			RawMemory<T> new_data(new_capacity);
+			size_t spare = new_capacity - size_ - 1;
+			size_t new_front = offset == 0 ? spare - spare / 2 : spare / 2;	// growing at the front - leave more room there
+
+			T* new_begin = new_data.GetAddress() + new_front;
+			T* result = new (new_begin + offset) T(std::forward<Args>(args)...);
+			try {
+				Relocate(begin(), offset, new_begin);
+				try {
+					Relocate(begin() + offset, size_ - offset, new_begin + offset + 1);
+				}
+				catch (...) {
+					std::destroy_n(new_begin, offset);
+					throw;
+				}
+			}
+			catch (...) {
+				std::destroy_at(result);	// in case of throwing exception, destroy only the new element
+				throw;
+			}
+			std::destroy_n(begin(), size_);
+			data_.Swap(new_data);
+			front_ = new_front;
+			++size_;
+			return result;
+		}
+
+		RawMemory<T> data_;		// Allocated raw memory
+		size_t front_ = 0;		// Index of the first element in raw memory
+		size_t size_ = 0;
+};
@@ -0,0 +1,193 @@
+#pragma once
+
+#include "vector.h"
+
+template <typename T>
+class GapVector {	// Elements live in [0, gap_begin_) and [gap_end_, capacity), the gap follows the edit point
+
+	public:
+
+		// --- Constructors ---
+
+		GapVector() = default;
+
+		explicit GapVector(size_t size)
+			: data_(size)
+			, gap_begin_(size)
+			, gap_end_(size)
+		{
+			std::uninitialized_value_construct_n(data_.GetAddress(), size);
+		}
+
+		GapVector(const GapVector& other)
+			: data_(other.Capacity())
+			, gap_begin_(other.gap_begin_)
+			, gap_end_(other.gap_end_)
+		{
+			std::uninitialized_copy_n(other.data_.GetAddress(), gap_begin_, data_.GetAddress());
+			try {
+				std::uninitialized_copy_n(other.data_ + gap_end_, Capacity() - gap_end_, data_ + gap_end_);
+			}
+			catch (...) {
+				std::destroy_n(data_.GetAddress(), gap_begin_);
+				throw;
+			}
+		}
+
+		GapVector(GapVector&& other) noexcept { Swap(other); }
+
+		// --- Destructor ---
+
+		~GapVector() {
+			std::destroy_n(data_.GetAddress(), gap_begin_);
+			std::destroy_n(data_ + gap_end_, Capacity() - gap_end_);
+		}
+
+		// --- Operators overloads ---
+
+		const T& operator[](size_t index) const noexcept { return const_cast<GapVector&>(*this)[index]; }	// Constancy trick to avoid duplication of assert
+			  T& operator[](size_t index)       noexcept {
+			assert(index < Size());
+			return index < gap_begin_ ? data_[index] : data_[index + GapSize()];
+		}
+
+		GapVector& operator=(const GapVector& rhs) {
+			if (this != &rhs) {				// checking for self-assignment
+				GapVector rhs_copy(rhs);	// copy-and-swap
+				Swap(rhs_copy);
+			}
+			return *this;
+		}
+
+		GapVector& operator=(GapVector&& rhs) noexcept {
+			if (this != &rhs) { Swap(rhs); }	// checking for self-assignment, swap
+			return *this;
+		}
+
+		// --- "std::vector"-like functions ---
+
+		size_t Size()        const noexcept { return Capacity() - GapSize(); }
+		size_t Capacity()    const noexcept { return data_.Capacity(); }
+		size_t GapPosition() const noexcept { return gap_begin_; }			// Logical index where the next local edit is O(1)
+		size_t GapSize()     const noexcept { return gap_end_ - gap_begin_; }
+
+		void Swap(GapVector& other) noexcept {
+			data_.Swap(other.data_);
+			std::swap(gap_begin_, other.gap_begin_);
+			std::swap(gap_end_, other.gap_end_);
+		}
+
+		void Reserve(size_t new_capacity) {		// Reallocate, the gap keeps its position and takes all the spare capacity
+			if (new_capacity <= Capacity()) { return; }
+			RawMemory<T> new_data(new_capacity);
+			size_t suffix = Capacity() - gap_end_;
+			size_t new_gap_end = new_capacity - suffix;
+			Relocate(data_.GetAddress(), gap_begin_, new_data.GetAddress());
+			try {
+				Relocate(data_ + gap_end_, suffix, new_data + new_gap_end);
+			}
+			catch (...) {
+				std::destroy_n(new_data.GetAddress(), gap_begin_);
+				throw;
+			}
+			std::destroy_n(data_.GetAddress(), gap_begin_);
+			std::destroy_n(data_ + gap_end_, suffix);
+			data_.Swap(new_data);
+			gap_end_ = new_gap_end;
+		}
+
+		void MoveGap(size_t index) {	// Costs only the distance moved
+			assert(index <= Size());
+			if (GapSize() == 0) {					// an empty gap can be placed anywhere for free
+				gap_begin_ = gap_end_ = index;
+				return;
+			}
+			while (gap_begin_ > index) {			// shift elements from the left of the gap to its right
+				new (data_ + gap_end_ - 1) T(std::move(data_[gap_begin_ - 1]));
+				std::destroy_at(data_ + gap_begin_ - 1);
+				--gap_begin_;						// only after the move, a throw leaves the bounds consistent
+				--gap_end_;
+			}
+			while (gap_begin_ < index) {			// shift elements from the right of the gap to its left
+				new (data_ + gap_begin_) T(std::move(data_[gap_end_]));
+				std::destroy_at(data_ + gap_end_);
+				++gap_begin_;
+				++gap_end_;
+			}
+		}
+
+		template <typename Type>
+		void PushBack(Type&& value) { Emplace(Size(), std::forward<Type>(value)); }
+
+		template <typename... Args>
+		T& Emplace(size_t index, Args&&... args) {	// O(1) when index is the gap position and the gap is not empty
+			assert(index <= Size());
+			if (index != gap_begin_ || GapSize() == 0) {
+				T value(std::forward<Args>(args)...);	// args may refer to an element that is about to be moved
+				PrepareGap(index);
+				T& result = *new (data_ + gap_begin_) T(std::move(value));
+				++gap_begin_;						// counted only once constructed - the destructor must not see a throw's slot
+				return result;
+			}
+			T& result = *new (data_ + gap_begin_) T(std::forward<Args>(args)...);
+			++gap_begin_;
+			return result;
+		}
+
+		void Insert(size_t index, const T& value) { Emplace(index, value)           ; }
+		void Insert(size_t index, T&& value     ) { Emplace(index, std::move(value)); }
+
+		void Erase(size_t index) {		// Erasing right before or right after the gap does not move anything
+			assert(index < Size());
+			if (index + 1 == gap_begin_) {
+				std::destroy_at(data_ + --gap_begin_);
+				return;
+			}
+			MoveGap(index);
+			std::destroy_at(data_ + gap_end_++);
+		}
+
+		void Clear() noexcept {
+			std::destroy_n(data_.GetAddress(), gap_begin_);
+			std::destroy_n(data_ + gap_end_, Capacity() - gap_end_);
+			gap_begin_ = 0;
+			gap_end_ = Capacity();
+		}
+
+		T* Materialize() {		// Move the gap to the end so that all elements are contiguous for scans
+			MoveGap(Size());
+			return data_.GetAddress();
+		}
+
+		Vector<T> ToVector() const {
+			Vector<T> result;
+			result.Reserve(Size());
+			for (size_t i = 0; i < Size(); ++i) {
+				result.PushBack((*this)[i]);
+			}
+			return result;
+		}
+
+	private:
+
+		static void Relocate(T* from, size_t count, T* to) {	// Move elements unless their move constructor throws and they can be copied
+			if constexpr (std::is_nothrow_move_constructible_v<T> || !std::is_copy_constructible_v<T>) {
+				std::uninitialized_move_n(from, count, to);
+			}
+			else {
+				std::uninitialized_copy_n(from, count, to);
+			}
+		}
+
+		void PrepareGap(size_t index) {
+			if (GapSize() == 0) {
+				int size_factor = 2;	// raw memory increase factor like in Vector
+				Reserve(Capacity() == 0 ? 1 : Capacity() * size_factor);
+			}
+			MoveGap(index);
+		}
+
+		RawMemory<T> data_;		// Allocated raw memory
+		size_t gap_begin_ = 0;	// First slot of the gap
+		size_t gap_end_ = 0;	// First slot after the gap
+};
@@ -0,0 +1,202 @@
+#pragma once
+
+#include "vector.h"
+#include "simd.h"
+
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+// Index-driven copies: Gather reads source[indices[i]] into output[i], Scatter writes source[i] to
+// output[indices[i]]. Random indices over a large source miss the cache on nearly every element, so
+// both loops prefetch the element PREFETCH_DISTANCE steps ahead, which keeps that many misses in
+// flight. Elements of 4 or 8 bytes are additionally moved by hardware gathers (AVX2, AVX-512) and
+// scatters (AVX-512 only). Scatter with repeated indices keeps the last write, as a plain loop would.
+
+namespace gather_detail {
+
+	inline constexpr size_t PREFETCH_DISTANCE = 16;		// Elements ahead; 0 turns prefetching off
+
+	template <typename T, typename Index>
+	inline constexpr bool IS_SIMD_PAIR = std::is_trivially_copyable_v<T> && (sizeof(T) == 4 || sizeof(T) == 8)
+		&& std::is_integral_v<Index> && (sizeof(Index) == 4 || sizeof(Index) == 8);
+
+	template <typename T, typename Index>
+	bool FitsSimdIndex(size_t size) noexcept {		// Hardware gathers sign-extend 32-bit indices
+		return sizeof(Index) == 8 || size <= static_cast<size_t>(std::numeric_limits<int32_t>::max());
+	}
+
+	template <typename Index>
+	void CheckIndices(Span<const Index> indices, size_t size) noexcept {
+#ifndef NDEBUG
+		for (const Index& index : indices) { assert(static_cast<size_t>(index) < size); }
+#else
+		(void)indices;
+		(void)size;
+#endif
+	}
+
+	template <typename T, typename Index>
+	void ScalarGather(const T* source, const Index* indices, T* output, size_t begin, size_t count, size_t prefetch) {
+		for (size_t i = begin; i < count; ++i) {
+			if (prefetch != 0 && i + prefetch < count) { VECTOR_PREFETCH(source + indices[i + prefetch], 0); }
+			output[i] = source[indices[i]];
+		}
+	}
+
+	template <typename T, typename Index>
+	void ScalarScatter(const T* source, const Index* indices, T* output, size_t begin, size_t count, size_t prefetch) {
+		for (size_t i = begin; i < count; ++i) {
+			if (prefetch != 0 && i + prefetch < count) { VECTOR_PREFETCH(output + indices[i + prefetch], 1); }
+			output[indices[i]] = source[i];
+		}
+	}
+
+	template <int WRITE, typename T, typename Index>
+	void PrefetchBlock(const T* base, const Index* indices, size_t from, size_t width, size_t count) noexcept {
+		size_t end = from + width < count ? from + width : count;
+		for (size_t i = from; i < end; ++i) { VECTOR_PREFETCH(base + indices[i], WRITE); }
+	}
+
+#if VECTOR_SIMD_X86
+
+	// Elements are moved as raw 32/64-bit lanes; the kernels return how many they handled, the scalar loop does the rest.
+	// The AVX-512 gathers use the all-lanes masked form, whose merge source is defined (GCC 12 warns on the unmasked one).
+
+	template <typename T, typename Index>
+	SIMD_TARGET_AVX2 size_t Avx2Gather(const T* source, const Index* indices, T* output, size_t count, size_t prefetch) noexcept {
+		constexpr size_t W = sizeof(Index) == 4 && sizeof(T) == 4 ? 8 : 4;
+		size_t i = 0;
+		for (; i + W <= count; i += W) {
+			if (prefetch != 0) { PrefetchBlock<0>(source, indices, i + prefetch, W, count); }
+			const void* index = indices + i;
+			if constexpr (sizeof(T) == 4 && sizeof(Index) == 4) {
+				__m256i lanes = _mm256_i32gather_epi32(reinterpret_cast<const int*>(source), _mm256_loadu_si256(static_cast<const __m256i*>(index)), 4);
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i), lanes);
+			}
+			else if constexpr (sizeof(T) == 8 && sizeof(Index) == 4) {
+				__m256i lanes = _mm256_i32gather_epi64(reinterpret_cast<const long long*>(source), _mm_loadu_si128(static_cast<const __m128i*>(index)), 8);
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i), lanes);
+			}
+			else if constexpr (sizeof(T) == 8) {
+				__m256i lanes = _mm256_i64gather_epi64(reinterpret_cast<const long long*>(source), _mm256_loadu_si256(static_cast<const __m256i*>(index)), 8);
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i), lanes);
+			}
+			else {
+				__m128i lanes = _mm256_i64gather_epi32(reinterpret_cast<const int*>(source), _mm256_loadu_si256(static_cast<const __m256i*>(index)), 4);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), lanes);
+			}
+		}
+		return i;
+	}
+
+	template <typename T, typename Index>
+	SIMD_TARGET_AVX512 size_t Avx512Gather(const T* source, const Index* indices, T* output, size_t count, size_t prefetch) noexcept {
+		constexpr size_t W = sizeof(Index) == 4 && sizeof(T) == 4 ? 16 : 8;
+		size_t i = 0;
+		for (; i + W <= count; i += W) {
+			if (prefetch != 0) { PrefetchBlock<0>(source, indices, i + prefetch, W, count); }
+			const void* index = indices + i;
+			if constexpr (sizeof(T) == 4 && sizeof(Index) == 4) {
+				_mm512_storeu_si512(output + i, _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), 0xFFFF, _mm512_loadu_si512(index), source, 4));
+			}
+			else if constexpr (sizeof(T) == 8 && sizeof(Index) == 4) {
+				_mm512_storeu_si512(output + i, _mm512_mask_i32gather_epi64(_mm512_setzero_si512(), 0xFF, _mm256_loadu_si256(static_cast<const __m256i*>(index)), source, 8));
+			}
+			else if constexpr (sizeof(T) == 8) {
+				_mm512_storeu_si512(output + i, _mm512_mask_i64gather_epi64(_mm512_setzero_si512(), 0xFF, _mm512_loadu_si512(index), source, 8));
+			}
+			else {
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i), _mm512_mask_i64gather_epi32(_mm256_setzero_si256(), 0xFF, _mm512_loadu_si512(index), source, 4));
+			}
+		}
+		return i;
+	}
+
+	template <typename T, typename Index>
+	SIMD_TARGET_AVX512 size_t Avx512Scatter(const T* source, const Index* indices, T* output, size_t count, size_t prefetch) noexcept {
+		constexpr size_t W = sizeof(Index) == 4 && sizeof(T) == 4 ? 16 : 8;
+		size_t i = 0;
+		for (; i + W <= count; i += W) {		// lanes are written lowest first, so a repeated index keeps the later element
+			if (prefetch != 0) { PrefetchBlock<1>(output, indices, i + prefetch, W, count); }
+			const void* index = indices + i;
+			if constexpr (sizeof(T) == 4 && sizeof(Index) == 4) {
+				_mm512_i32scatter_epi32(output, _mm512_loadu_si512(index), _mm512_loadu_si512(source + i), 4);
+			}
+			else if constexpr (sizeof(T) == 8 && sizeof(Index) == 4) {
+				_mm512_i32scatter_epi64(output, _mm256_loadu_si256(static_cast<const __m256i*>(index)), _mm512_loadu_si512(source + i), 8);
+			}
+			else if constexpr (sizeof(T) == 8) {
+				_mm512_i64scatter_epi64(output, _mm512_loadu_si512(index), _mm512_loadu_si512(source + i), 8);
+			}
+			else {
+				_mm512_i64scatter_epi32(output, _mm512_loadu_si512(index), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i)), 4);
+			}
+		}
+		return i;
+	}
+
+#endif
+
+}  // namespace gather_detail
+
+template <typename T, typename Index>
+void Gather(Span<const T> source, Span<const Index> indices, Span<T> output, size_t prefetch = gather_detail::PREFETCH_DISTANCE) {
+	assert(output.Size() == indices.Size());
+	gather_detail::CheckIndices(indices, source.Size());
+	size_t done = 0;
+#if VECTOR_SIMD_X86
+	if constexpr (gather_detail::IS_SIMD_PAIR<T, Index>) {
+		if (gather_detail::FitsSimdIndex<T, Index>(source.Size())) {
+			SimdLevel level = ActiveSimdLevel();
+			if (level >= SimdLevel::AVX512)    { done = gather_detail::Avx512Gather(source.GetAddress(), indices.GetAddress(), output.GetAddress(), indices.Size(), prefetch); }
+			else if (level >= SimdLevel::AVX2) { done = gather_detail::Avx2Gather(source.GetAddress(), indices.GetAddress(), output.GetAddress(), indices.Size(), prefetch); }
+		}
+	}
+#endif
+	gather_detail::ScalarGather(source.GetAddress(), indices.GetAddress(), output.GetAddress(), done, indices.Size(), prefetch);
+}
+
+template <typename T, typename Index>
+void Scatter(Span<const T> source, Span<const Index> indices, Span<T> output, size_t prefetch = gather_detail::PREFETCH_DISTANCE) {
+	assert(source.Size() == indices.Size());
+	gather_detail::CheckIndices(indices, output.Size());
+	size_t done = 0;
+#if VECTOR_SIMD_X86
+	if constexpr (gather_detail::IS_SIMD_PAIR<T, Index>) {
+		if (gather_detail::FitsSimdIndex<T, Index>(output.Size()) && ActiveSimdLevel() >= SimdLevel::AVX512) {	// AVX2 has no scatter
+			done = gather_detail::Avx512Scatter(source.GetAddress(), indices.GetAddress(), output.GetAddress(), indices.Size(), prefetch);
+		}
+	}
+#endif
+	gather_detail::ScalarScatter(source.GetAddress(), indices.GetAddress(), output.GetAddress(), done, indices.Size(), prefetch);
+}
+
+template <typename T, typename Allocator, typename Index>
+Vector<T> Gather(const Vector<T, Allocator>& source, Span<const Index> indices, size_t prefetch = gather_detail::PREFETCH_DISTANCE) {
+	Vector<T> result;
+	if constexpr (std::is_trivially_copyable_v<T> && std::is_default_constructible_v<T>) {
+		result.Resize(indices.Size());
+		Gather(source.AsSpan(), indices, result.AsSpan(), prefetch);
+	}
+	else {
+		gather_detail::CheckIndices(indices, source.Size());
+		result.Reserve(indices.Size());
+		for (size_t i = 0; i < indices.Size(); ++i) {
+			if (prefetch != 0 && i + prefetch < indices.Size()) { VECTOR_PREFETCH(source.begin() + indices[i + prefetch], 0); }
+			result.PushBack(source[indices[i]]);
+		}
+	}
+	return result;
+}
+
+template <typename T, typename Allocator, typename Index, typename IndexAllocator>
+Vector<T> Gather(const Vector<T, Allocator>& source, const Vector<Index, IndexAllocator>& indices, size_t prefetch = gather_detail::PREFETCH_DISTANCE) {
+	return Gather(source, indices.AsSpan(), prefetch);
+}
+
+template <typename T, typename Allocator, typename Index, typename IndexAllocator, typename OutputAllocator>
+void Scatter(const Vector<T, Allocator>& source, const Vector<Index, IndexAllocator>& indices, Vector<T, OutputAllocator>& output, size_t prefetch = gather_detail::PREFETCH_DISTANCE) {
+	Scatter(source.AsSpan(), indices.AsSpan(), output.AsSpan(), prefetch);
+}
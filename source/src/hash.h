@@ -0,0 +1,169 @@
+#pragma once
+
+#include "simd.h"
+
+#include <cstdint>
+#include <cstring>
+
+// 64-bit non-cryptographic hash of a byte range. Short inputs take a wyhash-style loop of
+// 128-bit multiply-folds. Long inputs are first folded into eight 64-bit accumulators
+// 64 bytes per stripe, as xxh3 does. The AVX2 and scalar accumulator loops compute exactly
+// the same values, so a hash does not depend on the CPU it was computed on.
+
+namespace hash_detail {
+
+	inline constexpr uint64_t P0 = 0xa0761d6478bd642full;
+	inline constexpr uint64_t P1 = 0xe7037ed1a0b428dbull;
+	inline constexpr uint64_t P2 = 0x8ebc6af09c88c6e3ull;
+	inline constexpr uint64_t P3 = 0x589965cc75374cc3ull;
+	inline constexpr uint64_t SCRAMBLE_PRIME = 0x9E3779B1ull;		// 32-bit, so the SIMD path multiplies with one mul_epu32 per half
+
+	inline constexpr size_t STRIPE = 64;
+	inline constexpr size_t STRIPES_PER_BLOCK = 16;				// Accumulators are scrambled after every block
+	inline constexpr size_t LONG_INPUT = 512;					// From here on the accumulator loop pays off
+
+	inline constexpr uint64_t KEY[8] = {
+		0xbe4ba423396cfeb8ull, 0x1cad21f72c81017cull, 0xdb979083e96dd4deull, 0x1f67b3b7a4a44072ull,
+		0x78e5c0cc4ee679cbull, 0x2172ffcc7dd05a82ull, 0x8e2443f7744608b8ull, 0x4c263a81e69035e0ull,
+	};
+
+	inline uint64_t Read8(const uint8_t* p) noexcept { uint64_t value; std::memcpy(&value, p, 8); return value; }
+	inline uint64_t Read4(const uint8_t* p) noexcept { uint32_t value; std::memcpy(&value, p, 4); return value; }
+
+	inline uint64_t Mix(uint64_t a, uint64_t b) noexcept {	// 64x64 -> 128 multiply, high and low halves folded
+#if defined(__SIZEOF_INT128__)
+		__extension__ using Uint128 = unsigned __int128;	// __extension__ keeps -Wpedantic quiet
+		Uint128 product = static_cast<Uint128>(a) * b;
+		return static_cast<uint64_t>(product) ^ static_cast<uint64_t>(product >> 64);
+#else
+		uint64_t a_lo = a & 0xFFFFFFFF, a_hi = a >> 32, b_lo = b & 0xFFFFFFFF, b_hi = b >> 32;
+		uint64_t lo_lo = a_lo * b_lo, hi_lo = a_hi * b_lo, lo_hi = a_lo * b_hi, hi_hi = a_hi * b_hi;
+		uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xFFFFFFFF) + lo_hi;
+		uint64_t high = hi_hi + (hi_lo >> 32) + (cross >> 32);
+		uint64_t low = (cross << 32) | (lo_lo & 0xFFFFFFFF);
+		return low ^ high;
+#endif
+	}
+
+	inline uint64_t HashShort(const uint8_t* p, size_t length, uint64_t seed, uint64_t total_length) noexcept {
+		seed ^= Mix(seed ^ P0, P1);
+		while (length > 16) {
+			seed = Mix(Read8(p) ^ P1, Read8(p + 8) ^ seed);
+			p += 16;
+			length -= 16;
+		}
+		uint64_t a = 0;
+		uint64_t b = 0;
+		if (length >= 8) {		// overlapping reads cover 8..16 bytes without a byte loop
+			a = Read8(p);
+			b = Read8(p + length - 8);
+		}
+		else if (length >= 4) {
+			a = Read4(p);
+			b = Read4(p + length - 4);
+		}
+		else if (length > 0) {
+			a = (uint64_t{ p[0] } << 16) | (uint64_t{ p[length >> 1] } << 8) | p[length - 1];
+		}
+		return Mix(P1 ^ total_length, Mix(a ^ P1, b ^ seed));
+	}
+
+	inline void ScalarAccumulate(const uint8_t* p, size_t stripes, uint64_t* accumulators) noexcept {
+		for (size_t stripe = 0; stripe < stripes; ++stripe, p += STRIPE) {
+			for (size_t lane = 0; lane < 8; ++lane) {
+				uint64_t data = Read8(p + lane * 8);
+				uint64_t keyed = data ^ KEY[lane];
+				accumulators[lane] += (keyed & 0xFFFFFFFF) * (keyed >> 32);
+				accumulators[lane ^ 1] += data;		// the raw data survives a zero product
+			}
+		}
+	}
+
+	inline void ScalarScramble(uint64_t* accumulators) noexcept {
+		for (size_t lane = 0; lane < 8; ++lane) {
+			uint64_t value = accumulators[lane];
+			value ^= value >> 47;
+			value ^= KEY[7 - lane];
+			accumulators[lane] = value * SCRAMBLE_PRIME;
+		}
+	}
+
+#if VECTOR_SIMD_X86
+
+	SIMD_INLINE_AVX2 __m256i Avx2Stripe(__m256i accumulator, __m256i data, __m256i key) noexcept {
+		__m256i keyed = _mm256_xor_si256(data, key);
+		__m256i product = _mm256_mul_epu32(keyed, _mm256_srli_epi64(keyed, 32));	// low half times high half of every lane
+		__m256i swapped = _mm256_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));	// lane ^ 1
+		return _mm256_add_epi64(accumulator, _mm256_add_epi64(product, swapped));
+	}
+
+	SIMD_INLINE_AVX2 __m256i Avx2Scramble(__m256i accumulator, __m256i key) noexcept {
+		__m256i value = _mm256_xor_si256(accumulator, _mm256_srli_epi64(accumulator, 47));
+		value = _mm256_xor_si256(value, key);
+		__m256i prime = _mm256_set1_epi64x(static_cast<long long>(SCRAMBLE_PRIME));
+		__m256i low = _mm256_mul_epu32(value, prime);
+		__m256i high = _mm256_mul_epu32(_mm256_srli_epi64(value, 32), prime);
+		return _mm256_add_epi64(low, _mm256_slli_epi64(high, 32));	// 64-bit value times 32-bit prime, mod 2^64
+	}
+
+	SIMD_TARGET_AVX2 inline void Avx2Accumulate(const uint8_t* p, size_t stripes, uint64_t* accumulators, bool scramble) noexcept {
+		__m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(accumulators));
+		__m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(accumulators + 4));
+		__m256i key_low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(KEY));
+		__m256i key_high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(KEY + 4));
+		for (size_t stripe = 0; stripe < stripes; ++stripe, p += STRIPE) {
+			low = Avx2Stripe(low, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)), key_low);
+			high = Avx2Stripe(high, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 32)), key_high);
+		}
+		if (scramble) {
+			__m256i reversed_high = _mm256_permute4x64_epi64(key_high, _MM_SHUFFLE(0, 1, 2, 3));	// KEY[7 - lane]
+			__m256i reversed_low = _mm256_permute4x64_epi64(key_low, _MM_SHUFFLE(0, 1, 2, 3));
+			low = Avx2Scramble(low, reversed_high);
+			high = Avx2Scramble(high, reversed_low);
+		}
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(accumulators), low);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(accumulators + 4), high);
+	}
+
+#endif
+
+	inline void Accumulate(const uint8_t* p, size_t stripes, uint64_t* accumulators, bool scramble) noexcept {
+#if VECTOR_SIMD_X86
+		if (ActiveSimdLevel() >= SimdLevel::AVX2) {
+			Avx2Accumulate(p, stripes, accumulators, scramble);
+			return;
+		}
+#endif
+		ScalarAccumulate(p, stripes, accumulators);
+		if (scramble) { ScalarScramble(accumulators); }
+	}
+
+	inline uint64_t HashLong(const uint8_t* p, size_t length, uint64_t seed) noexcept {
+		uint64_t accumulators[8] = { P0 ^ seed, P1, P2, P3, P0 + seed, P1 ^ seed, P2 - seed, P3 + seed };
+		size_t stripes = length / STRIPE;
+		size_t done = 0;
+		while (done < stripes) {
+			size_t count = stripes - done < STRIPES_PER_BLOCK ? stripes - done : STRIPES_PER_BLOCK;
+			Accumulate(p + done * STRIPE, count, accumulators, count == STRIPES_PER_BLOCK);
+			done += count;
+		}
+		uint64_t merged = length * P0;
+		for (size_t lane = 0; lane < 8; lane += 2) {
+			merged ^= Mix(accumulators[lane] ^ KEY[lane], accumulators[lane + 1] ^ KEY[lane + 1]);
+		}
+		size_t tail = length - stripes * STRIPE;
+		return HashShort(p + stripes * STRIPE, tail, seed ^ merged, length);
+	}
+
+}  // namespace hash_detail
+
+inline uint64_t HashBytes(const void* data, size_t length, uint64_t seed = 0) noexcept {
+	const uint8_t* p = static_cast<const uint8_t*>(data);
+	return length < hash_detail::LONG_INPUT
+		? hash_detail::HashShort(p, length, seed, length)
+		: hash_detail::HashLong(p, length, seed);
+}
+
+inline uint64_t HashCombine(uint64_t seed, uint64_t value) noexcept {	// Order-dependent fold of one more hash into seed
+	return hash_detail::Mix(seed ^ hash_detail::P0, value ^ hash_detail::P1);
+}
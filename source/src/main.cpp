@@ -1,8 +1,34 @@
 #include "vector.h"
+#include "slot_map.h"
+#include "object_pool.h"
+#include "arena.h"
+#include "devector.h"
+#include "gap_vector.h"
+#include "tombstone_vector.h"
+#include "ring_buffer.h"
+#include "spsc_queue.h"
+#include "mpmc_queue.h"
+#include "rcu_vector.h"
+#include "cow_vector.h"
+#include "persistent_vector.h"
+#include "vector_expression.h"
+#include "pipeline.h"
+#include "parallel.h"
+#include "scan.h"
+#include "search.h"
+#include "selection.h"
+#include "merge.h"
+#include "set_operations.h"
+#include "dedup.h"
+#include "priority_queue.h"
+#include "gather.h"
 
+#include <algorithm>
 #include <iostream>
 #include <stdexcept>
 #include <string>
+#include <thread>
+#include <unordered_set>
 
 namespace {
 
@@ -97,8 +123,29 @@ namespace {
 		static inline int num_destroyed = 0;
 	};
 
+	struct FailingSink {		// Output iterator whose third assignment throws
+		int* assigned;
+		FailingSink& operator*() { return *this; }
+		FailingSink& operator++() { return *this; }
+		FailingSink& operator=(Obj&&) {
+			if (++*assigned == 3) { throw std::runtime_error("Oops"); }
+			return *this;
+		}
+	};
+
+	struct TaggedKey {			// No padding, yet equality and hash ignore the tag
+		int id = 0;
+		int tag = 0;
+		bool operator==(const TaggedKey& other) const noexcept { return id == other.id; }
+	};
+
 }  // namespace
 
+template <>
+struct std::hash<TaggedKey> {
+	size_t operator()(const TaggedKey& key) const noexcept { return std::hash<int>{}(key.id); }
+};
+
 void Test1() {
 	Obj::ResetCounters();
 	const size_t SIZE = 100500;
@@ -378,6 +425,1308 @@ void Test5() {
 	}
 }
 
+void Test6() {
+	const int ID = 42;
+	const size_t SIZE = 1000;
+	{
+		Obj::ResetCounters();
+		SlotMap<Obj> map;
+		Vector<SlotMap<Obj>::Handle> handles;
+		for (size_t i = 0; i < SIZE; ++i) {
+			handles.PushBack(map.Emplace(static_cast<int>(i)));
+		}
+		assert(map.Size() == SIZE);
+		for (size_t i = 0; i < SIZE; i += 2) {
+			assert(map.Erase(handles[i]));
+			assert(!map.Contains(handles[i]));
+			assert(map.Get(handles[i]) == nullptr);
+			assert(!map.Erase(handles[i]));
+		}
+		assert(map.Size() == SIZE / 2);
+		for (size_t i = 1; i < SIZE; i += 2) {
+			assert(map.Contains(handles[i]));
+			assert(map[handles[i]].id == static_cast<int>(i));
+		}
+		auto handle = map.Emplace(ID);					// reuses a freed slot with a new generation
+		assert(handle.index == handles[SIZE - 2].index);
+		assert(!map.Contains(handles[SIZE - 2]));
+		assert(map[handle].id == ID);
+
+		int count = 0;
+		for (const Obj& obj : map) {
+			assert(obj.id == ID || obj.id % 2 == 1);
+			++count;
+		}
+		assert(count == static_cast<int>(SIZE / 2 + 1));
+		map.Clear();
+		assert(map.Size() == 0);
+		assert(!map.Contains(handle));
+		assert(Obj::GetAliveObjectCount() == 0);
+	}
+	assert(Obj::GetAliveObjectCount() == 0);
+}
+
+void Test7() {
+	const int ID = 42;
+	const size_t SIZE = 1000;
+	{
+		Obj::ResetCounters();
+		ObjectPool<Obj> pool(16);
+		Vector<Obj*> objects;
+		for (size_t i = 0; i < SIZE; ++i) {
+			objects.PushBack(pool.Acquire(static_cast<int>(i)));
+		}
+		assert(pool.Capacity() >= SIZE);
+		assert(Obj::GetAliveObjectCount() == SIZE);
+		for (size_t i = 0; i < SIZE; ++i) {
+			assert(objects[i]->id == static_cast<int>(i));		// objects never move while the pool grows
+		}
+		const size_t capacity = pool.Capacity();
+		Obj* released = objects[SIZE / 2];
+		pool.Release(released);
+		Obj* reused = pool.Acquire(ID);								// the freed slot is recycled first
+		assert(reused == released);
+		assert(reused->id == ID);
+		objects[SIZE / 2] = reused;
+		for (Obj* obj : objects) {
+			pool.Release(obj);
+		}
+		assert(pool.Capacity() == capacity);
+		assert(Obj::GetAliveObjectCount() == 0);
+	}
+	{
+		Obj::ResetCounters();
+		ObjectPool<Obj> pool;
+		{
+			ObjectPool<Obj>::LocalCache cache(pool, 8);
+			Vector<Obj*> objects;
+			for (size_t i = 0; i < SIZE; ++i) {
+				objects.PushBack(cache.Acquire(static_cast<int>(i)));
+			}
+			for (Obj* obj : objects) {
+				cache.Release(obj);
+				assert(cache.Cached() <= 16);
+			}
+			assert(Obj::GetAliveObjectCount() == 0);
+		}
+		Obj* obj = pool.Acquire(ID);								// slots flushed by the cache are visible to the pool
+		assert(obj->id == ID);
+		pool.Release(obj);
+	}
+	assert(Obj::GetAliveObjectCount() == 0);
+}
+
+void Test8() {
+	const int ID = 42;
+	const size_t SIZE = 1000;
+	{
+		MonotonicArena arena(256);
+		void* first = arena.Allocate(1, 1);
+		void* second = arena.Allocate(8, 8);
+		assert(reinterpret_cast<uintptr_t>(second) % 8 == 0);
+		assert(static_cast<unsigned char*>(second) - static_cast<unsigned char*>(first) < 16);	// pointer bump inside one block
+		void* large = arena.Allocate(1024, 64);						// oversized request gets a dedicated block
+		assert(reinterpret_cast<uintptr_t>(large) % 64 == 0);
+		const size_t allocated = arena.BytesAllocated();
+		arena.Reset();
+		assert(arena.BytesUsed() == 0);
+		assert(arena.Allocate(1, 1) == first);						// blocks are reused after Reset
+		assert(arena.BytesAllocated() == allocated);
+	}
+	{
+		Obj::ResetCounters();
+		MonotonicArena arena;
+		{
+			ArenaVector<Obj> v{ ArenaAllocator<Obj>(arena) };
+			for (size_t i = 0; i < SIZE; ++i) {
+				v.EmplaceBack(static_cast<int>(i));
+			}
+			v.Insert(v.begin(), Obj{ ID });
+			assert(v.Size() == SIZE + 1);
+			assert(v[0].id == ID);
+			assert(v[SIZE].id == static_cast<int>(SIZE - 1));
+			assert(arena.BytesUsed() >= SIZE * sizeof(Obj));
+
+			ArenaVector<Obj> v_copy(v);
+			assert(&v_copy.GetAllocator().GetArena() == &arena);
+			assert(v_copy[SIZE / 2].id == v[SIZE / 2].id);
+		}
+		assert(Obj::GetAliveObjectCount() == 0);
+		arena.Reset();
+		ArenaVector<int> v(SIZE, ArenaAllocator<int>(arena));
+		assert(v.Size() == SIZE);
+		assert(v[SIZE - 1] == 0);
+	}
+}
+
+void Test9() {
+	const int ID = 42;
+	const size_t SIZE = 1000;
+	{
+		Obj::ResetCounters();
+		Devector<Obj> v;
+		for (size_t i = 0; i < SIZE; ++i) {
+			v.EmplaceFront(static_cast<int>(i));
+			v.EmplaceBack(static_cast<int>(i));
+		}
+		assert(v.Size() == 2 * SIZE);
+		assert(v[0].id == static_cast<int>(SIZE - 1));
+		assert(v[2 * SIZE - 1].id == static_cast<int>(SIZE - 1));
+		assert(v[SIZE - 1].id == 0 && v[SIZE].id == 0);
+		assert(v.Capacity() <= 8 * SIZE);						// amortized growth at both ends
+		assert(Obj::GetAliveObjectCount() == 2 * SIZE);
+
+		const int moves = Obj::num_moved;
+		v.PopFront();
+		v.PushFront(Obj{ ID });								// uses the slot freed at the front, no shifting
+		assert(Obj::num_moved == moves + 1);
+		assert(v[0].id == ID);
+
+		Obj* inserted = v.Insert(v.begin() + 2, Obj{ ID + 1 });
+		assert(inserted == &v[2]);
+		assert(v[2].id == ID + 1);
+		assert(v[3].id == static_cast<int>(SIZE - 3));
+		v.Erase(v.begin() + 2);
+		assert(v[2].id == static_cast<int>(SIZE - 3));
+		v.Erase(v.end() - 2);
+		assert(v.Size() == 2 * SIZE - 1);
+		assert(v[2 * SIZE - 2].id == static_cast<int>(SIZE - 1));
+
+		while (v.Size() > 0) {
+			v.PopFront();
+			if (v.Size() > 0) { v.PopBack(); }
+		}
+		assert(Obj::GetAliveObjectCount() == 0);
+	}
+	{
+		Devector<int> v(4);
+		for (int i = 0; i < 4; ++i) { v[i] = i; }
+		Devector<int> v_copy(v);
+		v.Insert(v.begin() + 1, 10);
+		v.Insert(v.begin() + 4, 20);
+		v.Insert(v.begin() + 3, v[1]);
+		const int expected[] = { 0, 10, 1, 10, 2, 20, 3 };
+		assert(v.Size() == 7);
+		for (size_t i = 0; i < v.Size(); ++i) { assert(v[i] == expected[i]); }
+		assert(v_copy.Size() == 4 && v_copy[3] == 3);
+		v.Resize(20);
+		assert(v.Size() == 20 && v[19] == 0 && v[6] == 3);
+	}
+	{
+		Devector<int> v;										// elements crowded at the back of a large buffer
+		for (int i = 0; i < 127; ++i) { v.PushBack(i); }
+		for (int i = 0; i < 120; ++i) { v.PopFront(); }
+		v.Resize(20);
+		assert(v.Size() == 20 && v[0] == 120 && v[6] == 126 && v[19] == 0);
+		assert(v.BackCapacity() + v.FrontCapacity() + v.Size() == v.Capacity());
+	}
+	assert(Obj::GetAliveObjectCount() == 0);
+}
+
+void Test10() {
+	const size_t SIZE = 1000;
+	{
+		Obj::ResetCounters();
+		GapVector<Obj> v;
+		for (size_t i = 0; i < SIZE; ++i) {
+			v.PushBack(Obj(static_cast<int>(i)));
+		}
+		assert(v.Size() == SIZE);
+
+		v.MoveGap(SIZE / 2);
+		const int moves = Obj::num_moved;
+		for (int i = 0; i < 10; ++i) {
+			v.Emplace(SIZE / 2 + i, -i);					// typing at the cursor does not shift anything
+		}
+		assert(v.GapPosition() == SIZE / 2 + 10);
+		v.Erase(SIZE / 2 + 9);								// backspace
+		v.Erase(SIZE / 2 + 9);								// delete
+		assert(Obj::num_moved - moves == 0);
+		assert(v.Size() == SIZE + 8);
+		assert(v[SIZE / 2 - 1].id == static_cast<int>(SIZE / 2 - 1));
+		assert(v[SIZE / 2].id == 0 && v[SIZE / 2 + 8].id == -8);
+		assert(v[SIZE / 2 + 9].id == static_cast<int>(SIZE / 2 + 1));
+
+		GapVector<Obj> v_copy(v);
+		const Obj* data = v.Materialize();
+		assert(v.GapPosition() == v.Size());
+		for (size_t i = 0; i < v.Size(); ++i) {
+			assert(data[i].id == v_copy[i].id);
+		}
+		Vector<Obj> flat = v_copy.ToVector();
+		assert(flat.Size() == v_copy.Size());
+		assert(flat[SIZE / 2 + 3].id == -3);
+	}
+	assert(Obj::GetAliveObjectCount() == 0);
+	{
+		Obj::ResetCounters();
+		GapVector<Obj> v;
+		v.PushBack(Obj(1));
+		v.Reserve(8);									// the next emplace constructs in place at the gap
+		Obj::default_construction_throw_countdown = 1;
+		try {
+			v.Emplace(1);
+			assert(false);
+		}
+		catch (const std::runtime_error&) {}
+		assert(v.Size() == 1 && Obj::GetAliveObjectCount() == 1);
+
+		Obj bomb(2);
+		bomb.throw_on_copy = true;
+		try {
+			v.Insert(0, bomb);							// away from the gap - copied before the gap moves
+			assert(false);
+		}
+		catch (const std::runtime_error&) {}
+		try {
+			v.Insert(v.GapPosition(), bomb);
+			assert(false);
+		}
+		catch (const std::runtime_error&) {}
+		assert(v.Size() == 1 && v[0].id == 1 && Obj::GetAliveObjectCount() == 2);
+	}
+	assert(Obj::GetAliveObjectCount() == 0);
+	{
+		GapVector<int> v(3);
+		v.Insert(0, 1);
+		v.Insert(4, 2);
+		v.Insert(2, v[0]);
+		const int expected[] = { 1, 0, 1, 0, 0, 2 };
+		assert(v.Size() == 6);
+		for (size_t i = 0; i < v.Size(); ++i) { assert(v[i] == expected[i]); }
+		v.Clear();
+		assert(v.Size() == 0);
+	}
+}
+
+void Test11() {
+	const size_t SIZE = 1000;
+	{
+		Obj::ResetCounters();
+		TombstoneVector<Obj> v;
+		for (size_t i = 0; i < SIZE; ++i) {
+			v.EmplaceBack(static_cast<int>(i));
+		}
+		const int moves = Obj::num_moved;
+		for (size_t i = 0; i < SIZE; i += 4) {
+			assert(v.Erase(i));								// below the threshold - nothing moves
+		}
+		assert(!v.Erase(0));
+		assert(Obj::num_moved == moves);
+		assert(v.Size() == SIZE - SIZE / 4);
+		assert(v.SlotCount() == SIZE);
+		assert(!v.IsAlive(4) && v.IsAlive(5));
+
+		size_t count = 0;
+		for (const Obj& obj : v) {
+			assert(obj.id % 4 != 0);
+			++count;
+		}
+		assert(count == v.Size());
+
+		v.EraseIf([](const Obj& obj) { return obj.id % 2 == 1; });	// crosses the threshold - compacted once
+		assert(v.DeadCount() == 0);
+		assert(v.Size() == SIZE / 4);
+		assert(v.SlotCount() == SIZE / 4);
+		for (size_t i = 0; i < v.SlotCount(); ++i) {
+			assert(v[i].id == static_cast<int>(4 * i + 2));
+		}
+		assert(Obj::GetAliveObjectCount() == static_cast<int>(SIZE / 4));
+	}
+	assert(Obj::GetAliveObjectCount() == 0);
+	{
+		TombstoneVector<int> v(0.9);
+		for (int i = 0; i < 200; ++i) { v.PushBack(i); }
+		for (size_t i = 0; i < 150; ++i) { v.Erase(i); }	// whole words of dead slots are skipped
+		auto it = v.begin();
+		assert(*it == 150 && it.Slot() == 150);
+		v.Compact();
+		assert(v.SlotCount() == 50 && v[0] == 150 && v[49] == 199);
+	}
+}
+
+void Test12() {
+	const size_t SIZE = 100;
+	{
+		Obj::ResetCounters();
+		RingBuffer<Obj> ring(SIZE);
+		assert(ring.Capacity() == 128);
+		for (size_t i = 0; i < ring.Capacity(); ++i) {
+			assert(ring.EmplaceBack(static_cast<int>(i)));
+		}
+		assert(ring.Full());
+		assert(!ring.EmplaceBack(-1));
+		for (size_t i = 0; i < 1000; ++i) {				// wraps around many times without moving elements
+			assert(ring.Front().id == static_cast<int>(i));
+			ring.PopFront();
+			ring.EmplaceBack(static_cast<int>(i + ring.Capacity()));
+		}
+		assert(ring.Size() == ring.Capacity());
+		assert(Obj::num_moved == 0);
+		RingBuffer<Obj> ring_copy(ring);
+		assert(ring_copy[0].id == ring[0].id);
+		assert(ring_copy.Back().id == ring.Back().id);
+		assert(Obj::GetAliveObjectCount() == 2 * 128);
+	}
+	assert(Obj::GetAliveObjectCount() == 0);
+	{
+		RingBuffer<int> ring(4, RingOverflow::OVERWRITE_OLDEST);
+		for (int i = 0; i < 6; ++i) { ring.PushBack(i); }
+		assert(ring.Size() == 4 && ring.Front() == 2 && ring.Back() == 5);
+	}
+	{
+		RingBuffer<char> ring(8);
+		auto writable = ring.WritableSpans();
+		assert(writable.Size() == 8 && writable.second_size == 0);
+		for (size_t i = 0; i < 6; ++i) { writable.first[i] = static_cast<char>('a' + i); }
+		ring.Commit(6);
+		ring.Consume(5);
+		writable = ring.WritableSpans();						// free space wraps around the end of memory
+		assert(writable.first_size == 2 && writable.second_size == 5);
+		writable.first[0] = 'g';
+		writable.first[1] = 'h';
+		writable.second[0] = 'i';
+		ring.Commit(3);
+		auto readable = ring.ReadableSpans();
+		assert(readable.first_size == 3 && readable.second_size == 1);
+		assert(readable.first[0] == 'f' && readable.second[0] == 'i');
+	}
+}
+
+void Test13() {
+	const size_t SIZE = 100'000;
+	{
+		Obj::ResetCounters();
+		SpscQueue<Obj> queue(4);
+		assert(queue.TryEmplace(1) && queue.TryEmplace(2) && queue.TryEmplace(3) && queue.TryEmplace(4));
+		assert(!queue.TryEmplace(5));
+		Obj obj;
+		assert(queue.TryPop(obj) && obj.id == 1);
+		assert(queue.SizeApprox() == 3);
+		assert(Obj::GetAliveObjectCount() == 4);
+	}
+	assert(Obj::GetAliveObjectCount() == 0);
+	{
+		SpscQueue<Obj> queue(8);
+		for (int i = 0; i < 5; ++i) { queue.TryEmplace(i); }
+		int assigned = 0;
+		try {
+			queue.TryPopBatch(FailingSink{ &assigned }, 5);
+			assert(false);
+		}
+		catch (const std::runtime_error&) {}
+		assert(queue.SizeApprox() == 3);			// two popped, the failed element is still queued
+		Obj obj;
+		assert(queue.TryPop(obj) && obj.id == 2);
+	}
+	assert(Obj::GetAliveObjectCount() == 0);		// nothing destroyed twice or leaked
+	{
+		SpscQueue<size_t> queue(64);
+		std::thread producer([&queue, SIZE] {
+			size_t batch[16];
+			for (size_t next = 0; next < SIZE;) {
+				size_t count = std::min<size_t>(16, SIZE - next);
+				for (size_t i = 0; i < count; ++i) { batch[i] = next + i; }
+				size_t pushed = queue.TryPushBatch(batch, count);
+				if (pushed == 0) { std::this_thread::yield(); }	// let the consumer run on a single core
+				next += pushed;
+			}
+		});
+		size_t expected = 0;
+		size_t out[8];
+		while (expected < SIZE) {							// elements arrive in order, nothing is lost or duplicated
+			size_t value = 0;
+			if (expected % 2 == 0 && queue.TryPop(value)) {
+				assert(value == expected);
+				++expected;
+			}
+			size_t popped = queue.TryPopBatch(out, 8);
+			if (popped == 0) { std::this_thread::yield(); }
+			for (size_t i = 0; i < popped; ++i) {
+				assert(out[i] == expected);
+				++expected;
+			}
+		}
+		producer.join();
+		assert(queue.SizeApprox() == 0);
+	}
+}
+
+void Test14() {
+	const size_t THREADS = 4;
+	const size_t PER_THREAD = 20'000;
+	{
+		Obj::ResetCounters();
+		MpmcQueue<Obj> queue(3);
+		assert(queue.Capacity() == 4);
+		Obj obj(1);
+		assert(queue.TryPush(obj));
+		assert(queue.TryPush(Obj(2)));
+		const Obj objs[] = { Obj(3), Obj(4), Obj(5) };
+		assert(queue.TryPushBatch(objs, 3) == 2);
+		assert(queue.TryPop(obj) && obj.id == 1);
+		Obj out[4];
+		assert(queue.TryPopBatch(out, 4) == 3);
+		assert(out[0].id == 2 && out[2].id == 4);
+		assert(!queue.TryPop(obj));
+		queue.Push(Obj(6));
+	}
+	assert(Obj::GetAliveObjectCount() == 0);
+	{
+		MpmcQueue<Obj> queue(4);
+		for (int i = 0; i < 4; ++i) { assert(queue.TryPush(Obj(i))); }
+		int assigned = 0;
+		try {
+			queue.TryPopBatch(FailingSink{ &assigned }, 4);
+			assert(false);
+		}
+		catch (const std::runtime_error&) {}
+		Obj obj;
+		assert(queue.TryPop(obj) && obj.id == 3);		// the element that failed to move out is dropped, its slot is free
+		for (int lap = 0; lap < 8; ++lap) {				// no position stalls on later laps
+			assert(queue.TryPush(Obj(lap)));
+			assert(queue.TryPop(obj) && obj.id == lap);
+		}
+	}
+	assert(Obj::GetAliveObjectCount() == 0);
+	{
+		MpmcQueue<size_t> queue(16);						// small capacity so that producers block too
+		Vector<std::thread> producers;
+		Vector<std::thread> consumers;
+		std::atomic<size_t> sum{ 0 };
+		for (size_t t = 0; t < THREADS; ++t) {
+			producers.EmplaceBack([&queue, t, PER_THREAD] {
+				for (size_t i = 0; i < PER_THREAD; ++i) { queue.Push(t * PER_THREAD + i + 1); }
+			});
+			consumers.EmplaceBack([&queue, &sum, PER_THREAD] {
+				size_t local = 0;
+				for (size_t i = 0; i < PER_THREAD; ++i) {
+					size_t value = 0;
+					queue.Pop(value);
+					local += value;
+				}
+				sum += local;
+			});
+		}
+		for (std::thread& thread : producers) { thread.join(); }
+		for (std::thread& thread : consumers) { thread.join(); }
+		const size_t total = THREADS * PER_THREAD;
+		assert(sum == total * (total + 1) / 2);				// every element is delivered exactly once
+		assert(queue.SizeApprox() == 0);
+	}
+}
+
+void Test15() {
+	const size_t THREADS = 4;
+	const int VERSIONS = 200;
+	{
+		Obj::ResetCounters();
+		Vector<Obj> initial;
+		initial.EmplaceBack(0);
+		RcuVector<Obj> rcu(std::move(initial));
+		auto reader = rcu.RegisterReader();
+		{
+			auto snapshot = reader.Read();
+			rcu.Update([](Vector<Obj>& v) { v[0].id = 1; });
+			assert((*snapshot)[0].id == 0);				// the old version stays alive and unchanged
+			assert(rcu.Reclaim() == 1);
+		}
+		assert(rcu.Reclaim() == 0);						// reclaimed once the reader has left
+		assert(reader.Read()->Size() == 1);
+		assert((*reader.Read())[0].id == 1);
+		assert(Obj::GetAliveObjectCount() == 1);
+	}
+	assert(Obj::GetAliveObjectCount() == 0);
+	{
+		RcuVector<int> rcu(Vector<int>(2));
+		std::atomic<bool> stop{ false };
+		Vector<std::thread> readers;
+		for (size_t t = 0; t < THREADS; ++t) {
+			readers.EmplaceBack([&rcu, &stop] {
+				auto reader = rcu.RegisterReader();
+				while (!stop.load()) {
+					auto snapshot = reader.Read();
+					assert((*snapshot)[0] == (*snapshot)[1]);	// writers never expose a half-updated version
+					std::this_thread::yield();
+				}
+			});
+		}
+		for (int i = 1; i <= VERSIONS; ++i) {
+			rcu.Update([i](Vector<int>& v) { v[0] = i; v[1] = i; });
+		}
+		stop = true;
+		for (std::thread& thread : readers) { thread.join(); }
+		assert(rcu.Reclaim() == 0);
+		assert((*rcu.RegisterReader().Read())[1] == VERSIONS);
+	}
+}
+
+void Test16() {
+	const int ID = 42;
+	const size_t SIZE = 100;
+	{
+		Obj::ResetCounters();
+		CowVector<Obj> v(SIZE);
+		CowVector<Obj> snapshot(v);
+		CowVector<Obj> snapshot2;
+		snapshot2 = snapshot;
+		assert(Obj::num_copied == 0);					// copies share the buffer
+		assert(v.UseCount() == 3);
+		assert(&v[0] == &snapshot2[0]);
+
+		v.MutableAt(0).id = ID;							// first write duplicates the buffer
+		assert(Obj::num_copied == static_cast<int>(SIZE));
+		assert(v[0].id == ID && snapshot[0].id == 0);
+		assert(!v.IsShared() && snapshot.UseCount() == 2);
+
+		v.MutableAt(1).id = ID;							// further writes stay in place
+		v.EmplaceBack(ID);
+		assert(Obj::num_copied == static_cast<int>(SIZE));
+		assert(v.Size() == SIZE + 1 && snapshot.Size() == SIZE);
+
+		snapshot2.PushBack(snapshot[0]);
+		assert(snapshot2.Size() == SIZE + 1 && snapshot.Size() == SIZE);
+		assert(!snapshot.IsShared());
+		assert(Obj::GetAliveObjectCount() == static_cast<int>(3 * SIZE + 2));
+	}
+	assert(Obj::GetAliveObjectCount() == 0);
+	{
+		CowVector<int> v{ Vector<int>(SIZE) };
+		CowVector<int> before = v;
+		size_t size = v.Update([](Vector<int>& elements) {	// one detach for the whole batch
+			for (int& x : elements) { x = ID; }
+			return elements.Size();
+		});
+		assert(size == SIZE && v[SIZE - 1] == ID && before[SIZE - 1] == 0);
+		CowVector<int> after = v;						// shares again - the next write detaches once more
+		v.Update([](Vector<int>& elements) { elements[0] = -1; });
+		assert(v[0] == -1 && after[0] == ID);
+	}
+	{
+		CowVector<int, true> shared{ Vector<int>(SIZE) };
+		Vector<std::thread> threads;
+		for (int t = 0; t < 4; ++t) {
+			threads.EmplaceBack([shared, t] {
+				CowVector<int, true> local(shared);
+				local.MutableAt(0) = t + 1;
+				assert(local[0] == t + 1);
+			});
+		}
+		for (std::thread& thread : threads) { thread.join(); }
+		assert(shared[0] == 0 && shared.UseCount() == 1);
+	}
+}
+
+void Test17() {
+	const size_t SIZE = 5000;
+	{
+		Vector<int> source;
+		for (size_t i = 0; i < SIZE; ++i) { source.PushBack(static_cast<int>(i)); }
+		auto v = PersistentVector<int>::FromVector(source);
+		assert(v.Size() == SIZE);
+		for (size_t i = 0; i < SIZE; ++i) { assert(v[i] == static_cast<int>(i)); }
+
+		auto changed = v.Set(SIZE / 2, -1);
+		auto grown = changed.PushBack(-2);
+		assert(v[SIZE / 2] == static_cast<int>(SIZE / 2));	// old versions stay intact
+		assert(changed[SIZE / 2] == -1 && changed.Size() == SIZE);
+		assert(grown[SIZE] == -2 && grown.Size() == SIZE + 1);
+
+		auto slice = v.Slice(37, 4321);
+		assert(slice.Size() == 4321 - 37);
+		for (size_t i = 0; i < slice.Size(); ++i) { assert(slice[i] == static_cast<int>(i + 37)); }
+
+		auto joined = v.Slice(0, 100).Concat(v.Slice(100, 2000)).Concat(v.Slice(2000, SIZE));
+		assert(joined.Size() == SIZE);
+		for (size_t i = 0; i < SIZE; ++i) { assert(joined[i] == static_cast<int>(i)); }
+		joined = joined.PushBack(static_cast<int>(SIZE)).Set(1500, 7);
+		assert(joined[SIZE] == static_cast<int>(SIZE) && joined[1500] == 7 && joined[1501] == 1501);
+
+		PersistentVector<int> small;
+		for (int i = 0; i < 100; ++i) {						// many small concats keep lookups correct
+			small = small.Concat(PersistentVector<int>().PushBack(i).PushBack(i));
+		}
+		Vector<int> flat = small.ToVector();
+		assert(flat.Size() == 200);
+		for (size_t i = 0; i < flat.Size(); ++i) { assert(flat[i] == static_cast<int>(i / 2)); }
+		assert(small.Slice(51, 149)[0] == 25);
+
+		PersistentVector<int> chain;						// one element at a time - the seam is rebalanced, the height stays logarithmic
+		for (int i = 0; i < 3000; ++i) { chain = chain.Concat(PersistentVector<int>().PushBack(i)); }
+		assert(chain.Size() == 3000 && chain.Height() <= 3);
+		for (size_t i = 0; i < chain.Size(); ++i) { assert(chain[i] == static_cast<int>(i)); }
+
+		PersistentVector<int> doubled = v.Slice(0, 77);		// uneven halves joined over and over
+		for (int round = 0; round < 6; ++round) { doubled = doubled.Concat(doubled.Slice(1, doubled.Size())); }
+		assert(doubled.Height() <= 3);
+		Vector<int> doubled_flat = doubled.ToVector();
+		for (size_t i = 0; i < doubled.Size(); ++i) { assert(doubled[i] == doubled_flat[i]); }
+	}
+	{
+		Obj::ResetCounters();
+		PersistentVector<int>::Transient builder;
+		for (int i = 0; i < 1000; ++i) { builder.PushBack(i); }
+		builder.Set(10, -10);
+		auto frozen = builder.Persistent();
+		builder.Set(10, 10);								// edits after freezing do not leak into the frozen version
+		builder.PushBack(1000);
+		assert(frozen[10] == -10 && frozen.Size() == 1000);
+		auto again = builder.Persistent();
+		assert(again[10] == 10 && again.Size() == 1001);
+
+		auto transient = frozen.AsTransient();
+		transient.Set(999, 0);
+		assert(transient.Persistent()[999] == 0 && frozen[999] == 999);
+	}
+}
+
+int SumOf(Span<const int> values) {
+	int sum = 0;
+	for (int value : values) { sum += value; }
+	return sum;
+}
+
+void Test18() {
+	const size_t ROWS = 4;
+	const size_t COLUMNS = 3;
+	{
+		Vector<int> v(10);
+		for (size_t i = 0; i < v.Size(); ++i) { v[i] = static_cast<int>(i); }
+		Span<int> middle = v.Subspan(2, 5);
+		assert(middle.Size() == 5 && middle.GetAddress() == &v[2]);	// a view, not a copy
+		middle[0] = 42;
+		assert(v[2] == 42);
+		assert(SumOf(v.Subspan(7)) == 7 + 8 + 9);
+		assert(SumOf(middle.First(2)) == 42 + 3);
+		assert(SumOf(middle.Last(1)) == 6);
+		assert(middle.Subspan(1, 0).Empty());
+
+		const Vector<int>& cv = v;
+		Span<const int> all = cv.AsSpan();
+		assert(all.Size() == 10 && all[9] == 9);
+	}
+	{
+		Vector<int> matrix(ROWS * COLUMNS);						// row-major
+		for (size_t i = 0; i < matrix.Size(); ++i) { matrix[i] = static_cast<int>(i); }
+		StridedSpan<int> column = matrix.AsSpan().Strided(COLUMNS, 1);
+		assert(column.Size() == ROWS);
+		assert(column[0] == 1 && column[3] == 10);
+		int sum = 0;
+		for (int value : column) { sum += value; }
+		assert(sum == 1 + 4 + 7 + 10);
+		assert(column.end() - column.begin() == static_cast<std::ptrdiff_t>(ROWS));
+		assert(column.Subspan(1, 2)[1] == 7);
+		assert(matrix.AsSpan().Strided(4).Size() == 3);
+
+		std::sort(column.begin(), column.end(), std::greater<>());	// random-access algorithms work on a column in place
+		assert(column[0] == 10 && column[3] == 1 && matrix[1] == 10 && matrix[0] == 0);
+		assert(*std::lower_bound(column.begin(), column.end(), 4, std::greater<>()) == 4);
+		assert(*(2 + column.begin()) == 4 && column.end() > column.begin() && column.begin() <= column.begin());
+	}
+}
+
+void Test19() {
+	const size_t SIZE = 1000;		// not a multiple of any register width or of the chunk size
+	const SimdLevel LEVELS[] = { SimdLevel::SCALAR, SimdLevel::AVX2, SimdLevel::AVX512 };
+	for (SimdLevel level : LEVELS) {
+		SimdLevelOverride() = level;	// clamped to what the CPU supports
+		{
+			Vector<float> a(SIZE), b(SIZE), c(SIZE), d(SIZE);
+			for (size_t i = 0; i < SIZE; ++i) {
+				b[i] = static_cast<float>(i);
+				c[i] = 2.0f;
+				d[i] = 1.0f;
+			}
+			a.Reserve(SIZE);
+			const float* buffer = a.begin();
+			a = b * c + d;
+			assert(a.begin() == buffer);	// evaluated into the existing buffer
+			for (size_t i = 0; i < SIZE; ++i) { assert(a[i] == 2.0f * i + 1.0f); }
+
+			a = (a - d) / 2.0f;				// the destination may also be an operand
+			for (size_t i = 0; i < SIZE; ++i) { assert(a[i] == static_cast<float>(i)); }
+		}
+		{
+			Vector<double> x(SIZE), y(SIZE);
+			for (size_t i = 0; i < SIZE; ++i) { x[i] = 0.5 * i; }
+			y = 3.0 * x - x;
+			for (size_t i = 0; i < SIZE; ++i) { assert(y[i] == 1.0 * i); }
+		}
+		{
+			Vector<int32_t> x(SIZE);
+			for (size_t i = 0; i < SIZE; ++i) { x[i] = static_cast<int32_t>(i); }
+			Vector<int32_t> y = Evaluate(x * x / 2 + 1);	// integer division takes the scalar kernel
+			assert(y.Size() == SIZE);
+			for (size_t i = 0; i < SIZE; ++i) { assert(y[i] == static_cast<int32_t>(i * i / 2 + 1)); }
+		}
+	}
+	SimdLevelOverride() = DetectSimdLevel();
+	{
+		Vector<float> empty;
+		Vector<float> result(3);
+		result = empty + empty;
+		assert(result.Size() == 0);
+	}
+	{
+		MonotonicArena arena;
+		ArenaVector<float> x(SIZE, ArenaAllocator<float>(arena));
+		for (size_t i = 0; i < SIZE; ++i) { x[i] = static_cast<float>(i); }
+		static_assert(vector_expression_detail::IsSimdVector<ArenaVector<float>>::value);	// arena operands keep the SIMD kernels
+		ArenaVector<float> y{ ArenaAllocator<float>(arena) };
+		y = x * 2.0f + x;
+		for (size_t i = 0; i < SIZE; ++i) { assert(y[i] == 3.0f * i); }
+	}
+	{
+		using namespace vector_expression_detail;
+		static_assert(ENABLE_OPERATOR<Vector<int32_t>, int>);
+		static_assert(ENABLE_OPERATOR<int16_t, Vector<int32_t>>);
+		static_assert(ENABLE_OPERATOR<Vector<double>, float>);
+		static_assert(ENABLE_OPERATOR<Vector<double>, int>);
+		static_assert(!ENABLE_OPERATOR<Vector<int32_t>, double>);	// `Vector<int32_t> * 2.5` would multiply by 2
+		static_assert(!ENABLE_OPERATOR<Vector<int32_t>, uint32_t>);
+		static_assert(!ENABLE_OPERATOR<Vector<int32_t>, int64_t>);
+		static_assert(!ENABLE_OPERATOR<double, Vector<float>>);
+		static_assert(!ENABLE_OPERATOR<Vector<float>, int>);			// ints above 2^24 do not fit a float
+	}
+}
+
+void Test20() {
+	Vector<int> v(100);
+	for (size_t i = 0; i < v.Size(); ++i) { v[i] = static_cast<int>(i); }
+	{
+		size_t calls = 0;
+		auto evens_squared = Pipe(v)
+			.Filter([&calls](int x) { ++calls; return x % 2 == 0; })
+			.Map([](int x) { return x * x; })
+			.Take(5);
+		assert(calls == 0);								// lazy until a terminal operation
+		Vector<int> result = evens_squared.Collect();
+		assert(result.Size() == 5 && result.Capacity() == 5);
+		assert(result[0] == 0 && result[1] == 4 && result[4] == 64);
+		assert(calls == 9);								// the source stopped as soon as Take was satisfied
+	}
+	{
+		Vector<std::string> names = Pipe(v).Take(3).Map([](int x) { return std::to_string(x); }).Collect();
+		assert(names.Size() == 3 && names[2] == "2");
+
+		Vector<std::string> labels(3);
+		labels[0] = "a"; labels[1] = "b"; labels[2] = "c";
+		auto zipped = Pipe(v).Filter([](int x) { return x >= 10; }).Zip(labels).Collect();
+		assert(zipped.Size() == 3);
+		assert(zipped[0].first == 10 && zipped[0].second == "a");
+		assert(zipped[2].first == 12 && zipped[2].second == "c");
+	}
+	{
+		Vector<int> sums = Pipe(v).Chunk(30).Map([](Span<const int> chunk) {
+			int sum = 0;
+			for (int x : chunk) { sum += x; }
+			return sum;
+		}).Collect();
+		assert(sums.Size() == 4);
+		assert(sums[0] == 435 && sums[3] == 90 * 10 + 45);	// last chunk is partial
+		assert(Pipe(v).Filter([](int x) { return x % 3 == 0; }).Count() == 34);
+		Vector<int> rare = Pipe(v).Filter([](int x) { return x % 50 == 0; }).Collect();
+		assert(rare.Size() == 2 && rare.Capacity() < v.Size());	// a Filter makes the hint loose, so nothing is reserved up front
+		assert(Pipe(v.Subspan(0, 0)).Chunk(4).Count() == 0);
+	}
+}
+
+void Test21() {
+	const size_t SIZE = 200'000;
+	Vector<int64_t> v(SIZE);
+	ParallelForEach(v, [](int64_t& x) { x = 1; });
+	{
+		Vector<int64_t> indices = ParallelTransform(v, [](int64_t x) { return x * 2; });
+		assert(indices.Size() == SIZE && indices[SIZE - 1] == 2);
+		for (size_t i = 0; i < SIZE; ++i) { v[i] = static_cast<int64_t>(i); }
+		int64_t expected = static_cast<int64_t>(SIZE) * (SIZE - 1) / 2;
+		assert(ParallelReduce(v, int64_t{ 0 }, std::plus<>()) == expected);
+		assert(ParallelReduce(v, int64_t{ 10 }, std::plus<>(), ReduceOrder::DETERMINISTIC) == expected + 10);
+		assert(ParallelReduce(Vector<int64_t>(), int64_t{ 7 }, std::plus<>()) == 7);
+	}
+	{
+		Vector<float> values(SIZE);
+		for (size_t i = 0; i < SIZE; ++i) { values[i] = 1.0f / static_cast<float>(i + 1); }
+		ThreadPool one(1);
+		ThreadPool three(3);
+		float first = ParallelReduce(values, 0.0f, std::plus<>(), ReduceOrder::DETERMINISTIC, one);
+		float second = ParallelReduce(values, 0.0f, std::plus<>(), ReduceOrder::DETERMINISTIC, three);
+		assert(first == second);		// bitwise equal regardless of thread count and timing
+	}
+	{
+		std::atomic<size_t> visited{ 0 };
+		ParallelFor(64, [&visited](size_t begin, size_t end) {	// nested loops help instead of blocking a worker
+			for (size_t i = begin; i < end; ++i) {
+				ParallelFor(100, [&visited](size_t b, size_t e) { visited += e - b; }, 10);
+			}
+		}, 1);
+		assert(visited == 6400);
+
+		ThreadPool one(1);
+		for (int round = 0; round < 200; ++round) {		// the group dies right after its last task notifies
+			std::atomic<int> done{ 0 };
+			TaskGroup group(one);
+			for (int i = 0; i < 4; ++i) {
+				group.Run([&done, &one] {
+					TaskGroup nested(one);					// the only worker waits on a nested group and runs it itself
+					nested.Run([&done] { ++done; });
+					nested.Wait();
+				});
+			}
+			group.Wait();
+			assert(done == 4);
+		}
+	}
+	{
+		bool thrown = false;
+		try {
+			ParallelFor(1000, [](size_t begin, size_t end) {
+				if (begin <= 500 && 500 < end) { throw std::runtime_error("task failed"); }
+			}, 10);
+		}
+		catch (const std::runtime_error&) {
+			thrown = true;
+		}
+		assert(thrown);
+	}
+}
+
+void Test22() {
+	const size_t SIZES[] = { 0, 1, 7, 8, 9, 1000, (size_t{ 1 } << 19) + 3 };	// the last one takes the two-pass parallel path
+	const SimdLevel LEVELS[] = { SimdLevel::SCALAR, SimdLevel::AVX2 };
+	for (SimdLevel level : LEVELS) {
+		SimdLevelOverride() = level;
+		for (size_t size : SIZES) {
+			Vector<int32_t> counts(size);
+			for (size_t i = 0; i < size; ++i) { counts[i] = static_cast<int32_t>(i % 5); }
+			Vector<int32_t> offsets = counts;
+			ExclusiveScan(offsets, int32_t{ 100 });
+			Vector<int32_t> totals = counts;
+			InclusiveScan(totals);
+			int32_t expected = 0;
+			for (size_t i = 0; i < size; ++i) {
+				assert(offsets[i] == 100 + expected);
+				expected += counts[i];
+				assert(totals[i] == expected);
+			}
+		}
+		{
+			Vector<float> f(1001);
+			Vector<double> d(1001);
+			for (size_t i = 0; i < f.Size(); ++i) {
+				f[i] = 1.0f;
+				d[i] = 0.5;
+			}
+			Vector<float> f_out(f.Size());
+			InclusiveScan(Span<const float>(f.AsSpan()), f_out.AsSpan());	// into a separate buffer
+			assert(f[1000] == 1.0f && f_out[1000] == 1001.0f);
+			ExclusiveScan(d);
+			for (size_t i = 0; i < d.Size(); ++i) { assert(d[i] == 0.5 * i); }
+		}
+	}
+	SimdLevelOverride() = DetectSimdLevel();
+}
+
+void Test23() {
+	const SimdLevel LEVELS[] = { SimdLevel::SCALAR, SimdLevel::SSE42, SimdLevel::AVX2, SimdLevel::AVX512 };
+	for (SimdLevel level : LEVELS) {
+		SimdLevelOverride() = level;
+		for (size_t size : { size_t{ 1 }, size_t{ 3 }, size_t{ 17 }, size_t{ 1000 } }) {
+			Vector<int32_t> ints(size);
+			Vector<uint64_t> wide(size);
+			Vector<float> floats(size);
+			for (size_t i = 0; i < size; ++i) {
+				ints[i] = static_cast<int32_t>(i % 7) - 3;
+				wide[i] = (uint64_t{ 1 } << 63) + i;			// above INT64_MAX - unsigned compares matter
+				floats[i] = static_cast<float>(size - i);
+			}
+			assert(Find(ints, -3) == 0);
+			assert(Find(ints, 42) == SEARCH_NPOS);
+			assert(Contains(wide, (uint64_t{ 1 } << 63) + size - 1));
+			assert(!Contains(wide, 5));
+			assert(Find(floats, 1.0f) == size - 1);			// a match in the scalar tail
+			size_t expected = 0;
+			for (size_t i = 0; i < size; ++i) { expected += ints[i] == 0; }
+			assert(Count(ints, 0) == expected);
+
+			std::pair<int32_t, int32_t> range = MinMax(ints);
+			assert(range.first == -3 && range.second == (size > 6 ? 3 : static_cast<int32_t>(size - 1) - 3));
+			std::pair<uint64_t, uint64_t> wide_range = MinMax(wide);
+			assert(wide_range.first == (uint64_t{ 1 } << 63) && wide_range.second == (uint64_t{ 1 } << 63) + size - 1);
+			assert(ArgMin(floats) == size - 1);
+		}
+	}
+	SimdLevelOverride() = DetectSimdLevel();
+	{
+		Vector<std::string> words(3);								// any equality-comparable type takes the scalar loop
+		words[0] = "a"; words[1] = "b"; words[2] = "b";
+		assert(Find(words, "b") == 1 && Count(words, "b") == 2);
+		assert(MinMax(words).second == "b");
+	}
+}
+
+void Test24() {
+	{
+		Vector<int> a(3), b(3), c(4);
+		for (int i = 0; i < 3; ++i) { a[i] = b[i] = c[i] = i; }
+		assert(a == b && !(a != b));
+		assert(a != c && a < c && c > a && a <= b && a >= b);	// a prefix orders first
+		b[2] = -1;
+		assert(b < a);
+		assert(a.Hash() == Vector<int>(a).Hash() && a.Hash() != b.Hash());
+	}
+	{
+		Vector<uint8_t> low(2), high(2);
+		low[0] = 1; low[1] = 0x7F;
+		high[0] = 1; high[1] = 0x80;
+		assert(low < high && !(high < low));						// memcmp compares bytes as unsigned
+		Vector<float> zeros(1), negative_zeros(1);
+		negative_zeros[0] = -0.0f;
+		assert(zeros == negative_zeros && zeros.Hash() == negative_zeros.Hash());
+	}
+	{
+		Vector<std::string> words(2);
+		words[0] = "alpha"; words[1] = "beta";
+		Vector<std::string> copy = words;
+		assert(words == copy && words.Hash() == copy.Hash());
+		copy[1] = "gamma";
+		assert(words < copy && words.Hash() != copy.Hash());
+
+		Vector<TaggedKey> keys(2), retagged(2);					// user operator== and std::hash, not the bytes
+		keys[0].id = retagged[0].id = 1;
+		retagged[1].tag = 7;
+		assert(keys == retagged && keys.Hash() == retagged.Hash());
+		retagged[1].id = 2;
+		assert(keys != retagged);
+	}
+	{
+		Vector<uint8_t> bytes(5000);								// long input - the accumulator loop
+		for (size_t i = 0; i < bytes.Size(); ++i) { bytes[i] = static_cast<uint8_t>(i * 31); }
+		uint64_t simd = bytes.Hash(7);
+		SimdLevelOverride() = SimdLevel::SCALAR;
+		uint64_t scalar = bytes.Hash(7);
+		SimdLevelOverride() = DetectSimdLevel();
+		assert(simd == scalar);									// identical on every CPU
+		assert(bytes.Hash(7) != bytes.Hash(8));
+		bytes[4321] ^= 1;
+		assert(bytes.Hash(7) != simd);
+	}
+	{
+		std::unordered_set<Vector<int>> seen;
+		for (int round = 0; round < 2; ++round) {
+			for (int size = 0; size < 50; ++size) {
+				Vector<int> key(static_cast<size_t>(size));
+				for (int i = 0; i < size; ++i) { key[i] = i * size; }
+				seen.insert(std::move(key));
+			}
+		}
+		assert(seen.size() == 50);
+	}
+}
+
+void Test25() {
+	const size_t SIZE = 100'000;
+	Vector<int> scores(SIZE);
+	for (size_t i = 0; i < SIZE; ++i) { scores[i] = static_cast<int>((i * 7919) % SIZE); }	// a permutation of 0..SIZE-1
+	{
+		Vector<int> top = TopK(scores, 100);
+		assert(top.Size() == 100);
+		for (size_t i = 0; i < top.Size(); ++i) { assert(top[i] == static_cast<int>(SIZE - 1 - i)); }	// best first
+
+		Vector<int> bottom = TopK(scores, 3, std::less<>());
+		assert(bottom.Size() == 3 && bottom[0] == 0 && bottom[2] == 2);
+		assert(TopK(scores, 0).Size() == 0);
+		assert(TopK(std::as_const(scores).Subspan(0, 5), 10).Size() == 5);
+	}
+	{
+		Vector<int> top = ParallelTopK(scores, 100);
+		assert(top == TopK(scores, 100));
+
+		Vector<std::string> names(5);
+		names[0] = "d"; names[1] = "a"; names[2] = "e"; names[3] = "c"; names[4] = "b";
+		Vector<std::string> first = TopK(names, 2, std::less<>());	// non-arithmetic types skip the block filter
+		assert(first[0] == "a" && first[1] == "b");
+	}
+	{
+		Vector<int> copy = scores;
+		NthElement(copy, SIZE / 2);
+		assert(copy[SIZE / 2] == static_cast<int>(SIZE / 2));
+		for (size_t i = 0; i < SIZE / 2; ++i) { assert(copy[i] <= copy[SIZE / 2]); }
+		NthElement(copy, 0, std::greater<>());
+		assert(copy[0] == static_cast<int>(SIZE - 1));
+	}
+}
+
+void Test26() {
+	const size_t RUNS = 7;
+	Vector<Vector<std::pair<int, size_t>>> runs(RUNS);	// (key, run) - the run tells whether ties stayed stable
+	size_t total = 0;
+	for (size_t run = 0; run < RUNS; ++run) {
+		size_t length = run == 3 ? 0 : 20'000 + run * 1'000;	// one empty run
+		for (size_t i = 0; i < length; ++i) { runs[run].EmplaceBack(static_cast<int>((i * (run + 1)) / 3), run); }	// many duplicate keys
+		total += length;
+	}
+	auto by_key = [](const std::pair<int, size_t>& a, const std::pair<int, size_t>& b) { return a.first < b.first; };
+
+	Vector<std::pair<int, size_t>> merged = MergeSorted(runs, by_key);
+	assert(merged.Size() == total && merged.Capacity() == total);
+	for (size_t i = 1; i < merged.Size(); ++i) {
+		assert(merged[i - 1].first < merged[i].first
+			|| (merged[i - 1].first == merged[i].first && merged[i - 1].second <= merged[i].second));	// equal keys keep run order
+	}
+
+	Vector<std::pair<int, size_t>> parallel = ParallelMergeSorted(runs, by_key);
+	assert(parallel == merged);								// exact co-ranking reproduces the sequential merge
+
+	{
+		LoserTree<std::pair<int, size_t>, decltype(by_key)> stream(runs.AsSpan(), by_key);	// streaming - fixed buffer, read in batches
+		Vector<std::pair<int, size_t>> buffer(1000);
+		size_t offset = 0;
+		while (size_t count = stream.Read(buffer.AsSpan())) {
+			for (size_t i = 0; i < count; ++i) { assert(buffer[i] == merged[offset + i]); }
+			offset += count;
+		}
+		assert(offset == total && stream.Empty());
+	}
+	{
+		Vector<Vector<int>> none;
+		assert(MergeSorted(none).Size() == 0);
+		Vector<Vector<int>> single(1);
+		single[0].PushBack(1);
+		single[0].PushBack(2);
+		assert(MergeSorted(single) == single[0]);
+	}
+}
+
+void Test27() {
+	Vector<uint32_t> evens;		// posting lists - sorted, no duplicates
+	Vector<uint32_t> triples;
+	Vector<uint32_t> rare;
+	for (uint32_t i = 0; i < 3000; ++i) { evens.PushBack(2 * i); }
+	for (uint32_t i = 0; i < 2000; ++i) { triples.PushBack(3 * i + 1); }
+	for (uint32_t i = 0; i < 40; ++i) { rare.PushBack(150 * i); }		// skewed sizes take the galloping path
+
+	auto reference = [](const Vector<uint32_t>& a, const Vector<uint32_t>& b, int operation) {
+		Vector<uint32_t> result(a.Size() + b.Size());
+		uint32_t* end = operation == 0 ? std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), result.begin())
+			: operation == 1 ? std::set_union(a.begin(), a.end(), b.begin(), b.end(), result.begin())
+			: std::set_difference(a.begin(), a.end(), b.begin(), b.end(), result.begin());
+		Vector<uint32_t> trimmed;
+		for (uint32_t* p = result.begin(); p != end; ++p) { trimmed.PushBack(*p); }
+		return trimmed;
+	};
+
+	const SimdLevel LEVELS[] = { SimdLevel::SCALAR, SimdLevel::AVX2 };
+	const Vector<uint32_t>* lists[] = { &evens, &triples, &rare };
+	for (SimdLevel level : LEVELS) {
+		SimdLevelOverride() = level;
+		for (const Vector<uint32_t>* a : lists) {
+			for (const Vector<uint32_t>* b : lists) {
+				Vector<uint32_t> both = reference(*a, *b, 0);
+				assert(Intersect(*a, *b) == both);
+				assert(IntersectCount(*a, *b) == both.Size());
+				assert(Union(*a, *b) == reference(*a, *b, 1));
+				assert(Difference(*a, *b) == reference(*a, *b, 2));
+			}
+		}
+
+		Vector<uint64_t> wide_a;
+		Vector<uint64_t> wide_b;
+		for (uint64_t i = 0; i < 1001; ++i) { wide_a.PushBack((uint64_t{ 1 } << 40) + 5 * i); }
+		for (uint64_t i = 0; i < 999; ++i) { wide_b.PushBack((uint64_t{ 1 } << 40) + 7 * i); }
+		assert(IntersectCount(wide_a, wide_b) == 143);		// multiples of 35 below 5000
+		assert(Difference(wide_a, wide_b).Size() == 1001 - 143);
+		assert(Union(wide_a, wide_b).Size() == 1001 + 999 - 143);
+	}
+	SimdLevelOverride() = DetectSimdLevel();
+
+	Vector<uint32_t> empty;
+	assert(Intersect(evens, empty).Size() == 0 && IntersectCount(empty, evens) == 0);
+	assert(Union(empty, evens) == evens && Difference(evens, empty) == evens);
+	assert(Difference(empty, evens).Size() == 0);
+}
+
+void Test28() {
+	{
+		Vector<std::string> words;		// sorted - runs collapse to their first element, the tail is destroyed once
+		for (const char* word : { "a", "a", "b", "c", "c", "c", "d" }) { words.PushBack(word); }
+		size_t capacity = words.Capacity();
+		Dedup(words);
+		assert(words.Size() == 4 && words[0] == "a" && words[3] == "d");
+		assert(words.Capacity() == capacity);
+
+		Vector<std::string> unsorted;
+		for (const char* word : { "pear", "fig", "pear", "kiwi", "fig", "fig", "plum" }) { unsorted.PushBack(word); }
+		DedupUnsorted(unsorted);
+		assert(unsorted.Size() == 4 && unsorted[0] == "pear" && unsorted[1] == "fig" && unsorted[2] == "kiwi" && unsorted[3] == "plum");
+	}
+	{
+		Vector<int64_t> values;			// radix path - negative keys must sort below positive ones
+		for (int64_t i = 0; i < 5000; ++i) { values.PushBack(((i * 7919) % 1000) - 500); }
+		Vector<int64_t> expected = values;
+		std::sort(expected.begin(), expected.end());
+		expected.Truncate(static_cast<size_t>(std::unique(expected.begin(), expected.end()) - expected.begin()));
+
+		Vector<int64_t> sorted = values;
+		SortDedup(sorted);
+		assert(sorted == expected && sorted.Size() == 1000 && sorted[0] == -500);
+
+		Vector<int64_t> first_seen = values;
+		DedupUnsorted(first_seen);
+		assert(first_seen.Size() == 1000);
+		for (size_t i = 0; i < first_seen.Size(); ++i) { assert(first_seen[i] == values[i]); }	// 7919 is coprime to 1000
+	}
+	{
+		Vector<uint32_t> large;
+		for (uint32_t i = 0; i < 200'000; ++i) { large.PushBack((i * 2654435761u) % 50'000); }
+		Vector<uint32_t> expected = large;
+		SortDedup(expected);
+		ParallelSortDedup(large);
+		assert(large == expected && large.Size() == 50'000);
+
+		MonotonicArena arena;
+		ArenaVector<uint32_t> in_arena{ ArenaAllocator<uint32_t>(arena) };	// no default-constructible allocator
+		for (uint32_t i = 0; i < 200'000; ++i) { in_arena.PushBack((i * 2654435761u) % 50'000); }
+		ParallelSortDedup(in_arena);
+		assert(in_arena.Size() == 50'000 && std::equal(in_arena.begin(), in_arena.end(), expected.begin()));
+	}
+}
+
+template <size_t ARITY>
+void CheckHeapOrder() {
+	Vector<int> values;
+	for (int i = 0; i < 1000; ++i) { values.PushBack((i * 7919) % 1013); }
+	PriorityQueue<int, std::less<>, ARITY> bulk(std::as_const(values).AsSpan());	// heapified in one pass
+	PriorityQueue<int, std::greater<>, ARITY> pushed{ std::greater<>() };				// min-heap, built one push at a time
+	for (int value : values) { pushed.Push(value); }
+	std::sort(values.begin(), values.end());
+	for (size_t i = 0; i < values.Size(); ++i) {
+		assert(bulk.Top() == values[values.Size() - 1 - i]);
+		bulk.Pop();
+		assert(pushed.Extract() == values[i]);
+	}
+	assert(bulk.Empty() && pushed.Empty());
+}
+
+void Test29() {
+	CheckHeapOrder<2>();
+	CheckHeapOrder<4>();
+	CheckHeapOrder<8>();
+	{
+		PriorityQueue<std::string> words(Vector<std::string>(3));	// adopts the buffer
+		words.Push("b");
+		words.Emplace(2, 'z');
+		assert(words.Size() == 5 && words.Top() == "zz");
+	}
+	{
+		const size_t SIDE = 20;					// Dijkstra on a weighted grid - every relaxation is a decrease-key
+		auto weight = [](size_t from, size_t to) { return static_cast<int>((from * 31 + to * 17) % 11 + 1); };
+		IndexedPriorityQueue<int, std::greater<>> frontier(SIDE * SIDE);
+		Vector<int> distance(SIDE * SIDE);
+		for (int& d : distance) { d = std::numeric_limits<int>::max(); }
+		distance[0] = 0;
+		frontier.Push(0, 0);
+		size_t updates = 0;
+		while (!frontier.Empty()) {
+			size_t node = frontier.TopId();
+			int base = frontier.Top();
+			frontier.Pop();
+			size_t row = node / SIDE, column = node % SIDE;
+			size_t neighbours[4] = { row > 0 ? node - SIDE : node, row + 1 < SIDE ? node + SIDE : node,
+				column > 0 ? node - 1 : node, column + 1 < SIDE ? node + 1 : node };
+			for (size_t next : neighbours) {
+				int candidate = base + weight(node, next);
+				if (next == node || candidate >= distance[next]) { continue; }
+				updates += frontier.Contains(next);
+				distance[next] = candidate;
+				frontier.PushOrUpdate(next, candidate);
+				assert(frontier.Priority(next) == candidate);
+			}
+		}
+		assert(updates > 0);
+
+		Vector<int> expected(SIDE * SIDE);		// Bellman-Ford reference
+		for (int& d : expected) { d = std::numeric_limits<int>::max(); }
+		expected[0] = 0;
+		for (bool changed = true; changed;) {
+			changed = false;
+			for (size_t node = 0; node < SIDE * SIDE; ++node) {
+				if (expected[node] == std::numeric_limits<int>::max()) { continue; }
+				size_t row = node / SIDE, column = node % SIDE;
+				size_t neighbours[4] = { row > 0 ? node - SIDE : node, row + 1 < SIDE ? node + SIDE : node,
+					column > 0 ? node - 1 : node, column + 1 < SIDE ? node + 1 : node };
+				for (size_t next : neighbours) {
+					if (next != node && expected[node] + weight(node, next) < expected[next]) {
+						expected[next] = expected[node] + weight(node, next);
+						changed = true;
+					}
+				}
+			}
+		}
+		assert(distance == expected);
+
+		IndexedPriorityQueue<int> queue;		// ids grow the map on demand, erase from the middle
+		for (size_t id = 0; id < 50; ++id) { queue.Push(id * 3, static_cast<int>(id)); }
+		queue.Erase(30);
+		queue.Update(3, 1000);
+		assert(queue.TopId() == 3 && !queue.Contains(30) && queue.Size() == 49);
+		queue.Pop();
+		assert(queue.Top() == 49);
+	}
+}
+
+template <typename T, typename Index>
+void CheckGatherScatter(size_t size) {
+	Vector<T> source(size);
+	Vector<Index> permutation(size);
+	for (size_t i = 0; i < size; ++i) {
+		source[i] = static_cast<T>(i * 3 + 1);
+		permutation[i] = static_cast<Index>((i * 7919) % size);		// 7919 is prime, so this is a permutation for sizes it does not divide
+	}
+	Vector<T> gathered = Gather(source, permutation);
+	for (size_t i = 0; i < size; ++i) { assert(gathered[i] == source[permutation[i]]); }
+
+	Vector<T> restored(size);
+	Scatter(gathered, permutation, restored);					// scatter by the same indices inverts the gather
+	assert(restored == source);
+
+	Vector<T> unprefetched(size);
+	Gather(std::as_const(source).AsSpan(), std::as_const(permutation).AsSpan(), unprefetched.AsSpan(), 0);
+	assert(unprefetched == gathered);
+}
+
+void Test30() {
+	const SimdLevel LEVELS[] = { SimdLevel::SCALAR, SimdLevel::AVX2, SimdLevel::AVX512 };
+	for (SimdLevel level : LEVELS) {
+		SimdLevelOverride() = level;
+		for (size_t size : { size_t{ 1 }, size_t{ 15 }, size_t{ 1000 } }) {
+			CheckGatherScatter<uint32_t, uint32_t>(size);
+			CheckGatherScatter<float, int32_t>(size);
+			CheckGatherScatter<uint64_t, uint32_t>(size);
+			CheckGatherScatter<double, size_t>(size);
+			CheckGatherScatter<int32_t, uint64_t>(size);
+		}
+
+		Vector<uint32_t> values(40);							// repeated indices - the later element wins
+		Vector<uint32_t> indices(40);
+		for (uint32_t i = 0; i < 40; ++i) {
+			values[i] = i;
+			indices[i] = i % 4;
+		}
+		Vector<uint32_t> output(4);
+		Scatter(values, indices, output);
+		assert(output[0] == 36 && output[1] == 37 && output[2] == 38 && output[3] == 39);
+	}
+	SimdLevelOverride() = DetectSimdLevel();
+
+	Vector<std::string> names(3);								// other types take the element-by-element path
+	names[0] = "zero"; names[1] = "one"; names[2] = "two";
+	Vector<size_t> order(4);
+	order[0] = 2; order[1] = 0; order[2] = 2; order[3] = 1;
+	Vector<std::string> picked = Gather(names, order);
+	assert(picked.Size() == 4 && picked[0] == "two" && picked[2] == "two" && picked[3] == "one");
+}
+
 int main() {
 	try {
 		Test1();
@@ -385,6 +1734,31 @@ int main() {
 		Test3();
 		Test4();
 		Test5();
+		Test6();
+		Test7();
+		Test8();
+		Test9();
+		Test10();
+		Test11();
+		Test12();
+		Test13();
+		Test14();
+		Test15();
+		Test16();
+		Test17();
+		Test18();
+		Test19();
+		Test20();
+		Test21();
+		Test22();
+		Test23();
+		Test24();
+		Test25();
+		Test26();
+		Test27();
+		Test28();
+		Test29();
+		Test30();
 	}
 	catch (const std::exception& e) {
 		std::cerr << e.what() << std::endl;
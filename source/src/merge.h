@@ -0,0 +1,221 @@
+#pragma once
+
+#include "vector.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <functional>
+
+// K-way merge of sorted ranges. Ties are taken from the lower source index first, so every merge
+// here is stable and the parallel merge produces exactly the sequential output.
+
+template <typename T, typename Compare = std::less<>>
+class LoserTree {	// Tournament tree over k sorted sources - each Pop replays one leaf-to-root path, log2(k) compares
+
+	public:
+
+		// --- Constructors ---
+
+		explicit LoserTree(Vector<Span<const T>> sources, Compare compare = Compare())
+			: sources_(std::move(sources))
+			, positions_(sources_.Size())
+			, tree_(sources_.Size() == 0 ? 1 : sources_.Size())
+			, compare_(std::move(compare))
+		{
+			Build();
+		}
+
+		template <typename Allocator>
+		explicit LoserTree(Span<const Vector<T, Allocator>> sources, Compare compare = Compare())
+			: LoserTree(AsSpans(sources), std::move(compare))
+		{}
+
+		template <typename Allocator>
+		explicit LoserTree(Span<Vector<T, Allocator>> sources, Compare compare = Compare())
+			: LoserTree(Span<const Vector<T, Allocator>>(sources), std::move(compare))
+		{}
+
+		// --- Streaming ---
+
+		bool Empty() const noexcept { return Exhausted(tree_[0]); }
+
+		const T& Top() const noexcept {		// Smallest remaining element
+			assert(!Empty());
+			return sources_[tree_[0]][positions_[tree_[0]]];
+		}
+
+		size_t TopSource() const noexcept { return tree_[0]; }
+
+		void Pop() noexcept {
+			assert(!Empty());
+			size_t winner = tree_[0];
+			++positions_[winner];
+			for (size_t node = (Leaves() + winner) / 2; node > 0; node /= 2) {	// the new head plays the stored losers on its way up
+				if (Before(tree_[node], winner)) { std::swap(tree_[node], winner); }
+			}
+			tree_[0] = winner;
+		}
+
+		size_t Read(Span<T> output) {	// Copy-assigns up to output.Size() elements in order, returns how many - the sources are const, so nothing is moved
+			size_t count = 0;
+			for (; count < output.Size() && !Empty(); ++count) {
+				output[count] = Top();
+				Pop();
+			}
+			return count;
+		}
+
+	private:
+
+		template <typename Allocator>
+		static Vector<Span<const T>> AsSpans(Span<const Vector<T, Allocator>> sources) {
+			Vector<Span<const T>> spans;
+			spans.Reserve(sources.Size());
+			for (const Vector<T, Allocator>& source : sources) { spans.PushBack(source.AsSpan()); }
+			return spans;
+		}
+
+		size_t Leaves() const noexcept { return sources_.Size(); }
+
+		bool Exhausted(size_t source) const noexcept { return source >= sources_.Size() || positions_[source] == sources_[source].Size(); }
+
+		bool Before(size_t a, size_t b) const {	// Head of a goes out before head of b, exhausted sources act as +infinity
+			if (Exhausted(a)) { return false; }
+			if (Exhausted(b)) { return true; }
+			const T& head_a = sources_[a][positions_[a]];
+			const T& head_b = sources_[b][positions_[b]];
+			if (compare_(head_a, head_b)) { return true; }
+			if (compare_(head_b, head_a)) { return false; }
+			return a < b;
+		}
+
+		void Build() {		// Leaf i sits at node k + i, internal nodes 1..k-1 keep the loser of their match
+			size_t k = Leaves();
+			if (k <= 1) {
+				tree_[0] = 0;
+				return;
+			}
+			Vector<size_t> winners(2 * k);
+			for (size_t i = 0; i < k; ++i) { winners[k + i] = i; }
+			for (size_t node = k - 1; node > 0; --node) {
+				size_t left = winners[2 * node];
+				size_t right = winners[2 * node + 1];
+				bool left_wins = Before(left, right);
+				winners[node] = left_wins ? left : right;
+				tree_[node] = left_wins ? right : left;
+			}
+			tree_[0] = winners[1];
+		}
+
+		Vector<Span<const T>> sources_;
+		Vector<size_t> positions_;		// Next element of every source
+		Vector<size_t> tree_;			// [0] - overall winner, [1..k-1] - losers
+		Compare compare_;
+};
+
+namespace merge_detail {
+
+	inline constexpr size_t PARALLEL_MIN_SIZE = 1 << 16;
+
+	template <typename T, typename Compare>
+	Vector<size_t> CoRank(const Vector<Span<const T>>& sources, size_t rank, Compare& compare) {	// Split so exactly rank elements, the first ones of the stable merge, lie before it
+		size_t k = sources.Size();
+		Vector<size_t> low(k);
+		Vector<size_t> high(k);
+		for (size_t i = 0; i < k; ++i) { high[i] = sources[i].Size(); }
+		Vector<size_t> before(k);
+		while (true) {
+			size_t pivot_source = k;
+			size_t widest = 0;
+			for (size_t i = 0; i < k; ++i) {
+				if (high[i] - low[i] > widest) {
+					widest = high[i] - low[i];
+					pivot_source = i;
+				}
+			}
+			if (pivot_source == k) { return low; }		// every range collapsed, low is the split
+
+			size_t pivot_position = low[pivot_source] + widest / 2;
+			const T& pivot = sources[pivot_source][pivot_position];
+			size_t pivot_rank = 0;
+			for (size_t i = 0; i < k; ++i) {	// elements ordered before the pivot under (value, source, position)
+				const T* first = sources[i].begin();
+				const T* last = sources[i].end();
+				if (i == pivot_source)     { before[i] = pivot_position; }
+				else if (i < pivot_source) { before[i] = std::upper_bound(first, last, pivot, compare) - first; }
+				else                       { before[i] = std::lower_bound(first, last, pivot, compare) - first; }
+				pivot_rank += before[i];
+			}
+			if (pivot_rank == rank) { return before; }
+			for (size_t i = 0; i < k; ++i) {
+				if (pivot_rank < rank) { low[i] = std::max(low[i], before[i] + (i == pivot_source ? 1 : 0)); }	// the pivot and all before it go left
+				else                   { high[i] = std::min(high[i], before[i]); }								// the pivot and all after it go right
+			}
+		}
+	}
+
+	template <typename T>
+	size_t TotalSize(const Vector<Span<const T>>& sources) noexcept {
+		size_t total = 0;
+		for (const Span<const T>& source : sources) { total += source.Size(); }
+		return total;
+	}
+
+}  // namespace merge_detail
+
+template <typename T, typename Allocator, typename Compare = std::less<>>
+Vector<T> MergeSorted(Span<const Vector<T, Allocator>> inputs, Compare compare = Compare()) {	// One allocation for the whole output
+	LoserTree<T, Compare> tree(inputs, compare);
+	size_t total = 0;
+	for (const Vector<T, Allocator>& input : inputs) { total += input.Size(); }
+	Vector<T> output;
+	output.Reserve(total);
+	for (; !tree.Empty(); tree.Pop()) { output.PushBack(tree.Top()); }
+	return output;
+}
+
+template <typename T, typename Allocator, typename Compare = std::less<>>
+Vector<T> MergeSorted(Span<Vector<T, Allocator>> inputs, Compare compare = Compare()) {
+	return MergeSorted(Span<const Vector<T, Allocator>>(inputs), std::move(compare));
+}
+
+template <typename T, typename Allocator, typename Compare = std::less<>>
+Vector<T> MergeSorted(const Vector<Vector<T, Allocator>>& inputs, Compare compare = Compare()) {
+	return MergeSorted(inputs.AsSpan(), std::move(compare));
+}
+
+template <typename T, typename Allocator, typename Compare = std::less<>>
+void ParallelMergeSorted(Span<const Vector<T, Allocator>> inputs, Span<T> output, Compare compare = Compare(), ThreadPool& pool = ThreadPool::Shared()) {
+	// Merge-path split: every task co-ranks its output segment in all inputs and merges only that slice
+	Vector<Span<const T>> sources;
+	sources.Reserve(inputs.Size());
+	for (const Vector<T, Allocator>& input : inputs) { sources.PushBack(input.AsSpan()); }
+	size_t total = output.Size();
+	assert(total == merge_detail::TotalSize(sources));
+
+	size_t segments = total < merge_detail::PARALLEL_MIN_SIZE ? 1 : (pool.ThreadCount() + 1) * parallel_detail::TASKS_PER_THREAD;
+	ParallelFor(segments, [&](size_t first, size_t last) {
+		for (size_t segment = first; segment < last; ++segment) {
+			size_t begin = total * segment / segments;
+			size_t end = total * (segment + 1) / segments;
+			Vector<size_t> from = merge_detail::CoRank(sources, begin, compare);
+			Vector<size_t> to = merge_detail::CoRank(sources, end, compare);
+			Vector<Span<const T>> slices;
+			slices.Reserve(sources.Size());
+			for (size_t i = 0; i < sources.Size(); ++i) { slices.PushBack(sources[i].Subspan(from[i], to[i] - from[i])); }
+			LoserTree<T, Compare> tree(std::move(slices), compare);
+			size_t written = tree.Read(output.Subspan(begin, end - begin));
+			assert(written == end - begin);
+			(void)written;
+		}
+	}, 1, pool);
+}
+
+template <typename T, typename Allocator, typename Compare = std::less<>>
+Vector<T> ParallelMergeSorted(const Vector<Vector<T, Allocator>>& inputs, Compare compare = Compare(), ThreadPool& pool = ThreadPool::Shared()) {	// T must be default constructible
+	size_t total = 0;
+	for (const Vector<T, Allocator>& input : inputs) { total += input.Size(); }
+	Vector<T> output(total);
+	ParallelMergeSorted(inputs.AsSpan(), output.AsSpan(), std::move(compare), pool);
+	return output;
+}
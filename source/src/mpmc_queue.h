@@ -0,0 +1,243 @@
+#pragma once
+
+#include "vector.h"
+#include "cache_line.h"
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <type_traits>
+
+#if defined(__linux__)
+#include <climits>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+class FutexEvent {	// Eventcount: waiters sleep on an epoch word that notifiers bump, no mutex on either side
+
+	public:
+
+		uint32_t PrepareWait() noexcept {	// Register as a waiter, then re-check the condition before Wait
+			waiters_.fetch_add(1, std::memory_order_seq_cst);
+			return epoch_.load(std::memory_order_seq_cst);
+		}
+
+		void CancelWait() noexcept { waiters_.fetch_sub(1, std::memory_order_seq_cst); }
+
+		void Wait(uint32_t epoch) noexcept {	// Sleeps unless the epoch has moved since PrepareWait
+#if defined(__linux__)
+			syscall(SYS_futex, reinterpret_cast<uint32_t*>(&epoch_), FUTEX_WAIT_PRIVATE, epoch, nullptr, nullptr, 0);
+#else
+			while (epoch_.load(std::memory_order_acquire) == epoch) { std::this_thread::yield(); }
+#endif
+			CancelWait();
+		}
+
+		void NotifyAll() noexcept {
+			epoch_.fetch_add(1, std::memory_order_seq_cst);
+			if (waiters_.load(std::memory_order_seq_cst) != 0) {	// the syscall is skipped while nobody sleeps
+#if defined(__linux__)
+				syscall(SYS_futex, reinterpret_cast<uint32_t*>(&epoch_), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+#endif
+			}
+		}
+
+	private:
+
+		std::atomic<uint32_t> epoch_{ 0 };
+		std::atomic<uint32_t> waiters_{ 0 };
+};
+
+template <typename T>
+class MpmcQueue {	// Bounded queue for any number of producers and consumers, each slot carries a sequence number
+
+	static_assert(std::is_nothrow_move_constructible_v<T>, "a claimed slot must always be published");
+
+	struct Slot {
+		std::atomic<size_t> sequence;					// position the slot is ready for: pos - free, pos + 1 - full
+		alignas(T) unsigned char storage[sizeof(T)];
+
+		T* Get() noexcept { return reinterpret_cast<T*>(storage); }
+	};
+
+	public:
+
+		// --- Constructors ---
+
+		explicit MpmcQueue(size_t min_capacity)	// Capacity is rounded up to a power of two
+			: slots_(RoundUpToPowerOfTwo(min_capacity))
+			, mask_(slots_.Capacity() - 1)
+		{
+			for (size_t i = 0; i < slots_.Capacity(); ++i) {
+				new (&slots_[i].sequence) std::atomic<size_t>(i);
+			}
+		}
+
+		MpmcQueue(const MpmcQueue&) = delete;
+		MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+		// --- Destructor ---
+
+		~MpmcQueue() {
+			size_t tail = enqueue_pos_.load(std::memory_order_relaxed);
+			for (size_t pos = dequeue_pos_.load(std::memory_order_relaxed); pos != tail; ++pos) {
+				std::destroy_at(slots_[pos & mask_].Get());
+			}
+			for (size_t i = 0; i < slots_.Capacity(); ++i) {
+				std::destroy_at(&slots_[i].sequence);
+			}
+		}
+
+		// --- Non-blocking functions ---
+
+		bool TryPush(T&& value) {	// false if the queue is full, value is moved from only on success
+			if (!TryPushNoNotify(std::move(value))) { return false; }
+			not_empty_.NotifyAll();
+			return true;
+		}
+
+		bool TryPush(const T& value) {
+			if (!TryPushNoNotify(value)) { return false; }
+			not_empty_.NotifyAll();
+			return true;
+		}
+
+		bool TryPop(T& value) {		// false if the queue is empty
+			if (!TryPopNoNotify([&value](T& item) { value = std::move(item); })) { return false; }
+			not_full_.NotifyAll();
+			return true;
+		}
+
+		template <typename InputIt>
+		size_t TryPushBatch(InputIt first, size_t count) {	// Waiting consumers are woken once per batch
+			size_t pushed = 0;
+			for (; pushed < count && TryPushNoNotify(*first); ++pushed, ++first) {}
+			if (pushed != 0) { not_empty_.NotifyAll(); }
+			return pushed;
+		}
+
+		template <typename OutputIt>
+		size_t TryPopBatch(OutputIt out, size_t max_count) {	// Waiting producers are woken once per batch
+			size_t popped = 0;
+			for (; popped < max_count && TryPopNoNotify([&out](T& item) { *out = std::move(item); }); ++popped, ++out) {}
+			if (popped != 0) { not_full_.NotifyAll(); }
+			return popped;
+		}
+
+		// --- Blocking functions (sleep on a futex instead of spinning) ---
+
+		void Push(T value) {
+			while (!TryPush(std::move(value))) {
+				uint32_t epoch = not_full_.PrepareWait();
+				if (TryPush(std::move(value))) {
+					not_full_.CancelWait();
+					return;
+				}
+				not_full_.Wait(epoch);
+			}
+		}
+
+		void Pop(T& value) {
+			while (!TryPop(value)) {
+				uint32_t epoch = not_empty_.PrepareWait();
+				if (TryPop(value)) {
+					not_empty_.CancelWait();
+					return;
+				}
+				not_empty_.Wait(epoch);
+			}
+		}
+
+		// --- Observers ---
+
+		size_t Capacity() const noexcept { return slots_.Capacity(); }
+
+		size_t SizeApprox() const noexcept {	// Exact only when no thread is running
+			size_t head = dequeue_pos_.load(std::memory_order_acquire);
+			size_t tail = enqueue_pos_.load(std::memory_order_acquire);
+			return tail - head;
+		}
+
+	private:
+
+		static size_t RoundUpToPowerOfTwo(size_t n) noexcept {
+			size_t result = 1;
+			while (result < n) { result <<= 1; }
+			return result;
+		}
+
+		bool TryPushNoNotify(const T& value) {
+			if constexpr (std::is_nothrow_copy_constructible_v<T>) {
+				return Enqueue(value);
+			}
+			else {
+				T copy(value);		// a throwing copy must happen before a slot is claimed
+				return Enqueue(std::move(copy));
+			}
+		}
+
+		bool TryPushNoNotify(T&& value) { return Enqueue(std::move(value)); }
+
+		template <typename Type>
+		bool Enqueue(Type&& value) noexcept {	// Constructing from value must not throw
+			size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+			Slot* slot = nullptr;
+			for (;;) {
+				slot = &slots_[pos & mask_];
+				size_t sequence = slot->sequence.load(std::memory_order_acquire);
+				intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+				if (diff == 0) {		// free for this lap - claim it
+					if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) { break; }
+				}
+				else if (diff < 0) {	// still holds the element from the previous lap
+					return false;
+				}
+				else {					// another producer took it
+					pos = enqueue_pos_.load(std::memory_order_relaxed);
+				}
+			}
+			new (slot->Get()) T(std::forward<Type>(value));
+			slot->sequence.store(pos + 1, std::memory_order_release);
+			return true;
+		}
+
+		template <typename Consume>
+		bool TryPopNoNotify(Consume consume) {
+			size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+			Slot* slot = nullptr;
+			for (;;) {
+				slot = &slots_[pos & mask_];
+				size_t sequence = slot->sequence.load(std::memory_order_acquire);
+				intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+				if (diff == 0) {		// published for this lap - claim it
+					if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) { break; }
+				}
+				else if (diff < 0) {	// not published yet
+					return false;
+				}
+				else {					// another consumer took it
+					pos = dequeue_pos_.load(std::memory_order_relaxed);
+				}
+			}
+			struct Release {		// frees the slot for the next lap even if consume throws - the element is then dropped
+				Slot* slot;
+				size_t sequence;
+				~Release() {
+					std::destroy_at(slot->Get());
+					slot->sequence.store(sequence, std::memory_order_release);
+				}
+			} release{ slot, pos + mask_ + 1 };
+			consume(*slot->Get());
+			return true;
+		}
+
+		RawMemory<Slot> slots_;		// Allocated raw memory, capacity is a power of two
+		size_t mask_;				// Capacity - 1
+
+		alignas(CACHE_LINE_SIZE) std::atomic<size_t> enqueue_pos_{ 0 };	// Contended by producers
+		alignas(CACHE_LINE_SIZE) std::atomic<size_t> dequeue_pos_{ 0 };	// Contended by consumers
+		alignas(CACHE_LINE_SIZE) FutexEvent not_empty_;						// Idle consumers sleep here
+		alignas(CACHE_LINE_SIZE) FutexEvent not_full_;						// Blocked producers sleep here
+};
@@ -0,0 +1,167 @@
+#pragma once
+
+#include "vector.h"
+
+#include <algorithm>
+#include <mutex>
+
+template <typename T>
+class ObjectPool {
+
+	union Node {							// a free slot stores the link, a busy slot stores the object
+		Node* next;
+		alignas(T) unsigned char storage[sizeof(T)];
+	};
+
+	public:
+
+		class LocalCache;
+
+		// --- Constructors ---
+
+		explicit ObjectPool(size_t initial_chunk_size = 64)
+			: next_chunk_size_(initial_chunk_size == 0 ? 1 : initial_chunk_size)
+		{}
+
+		ObjectPool(const ObjectPool&) = delete;
+		ObjectPool& operator=(const ObjectPool&) = delete;
+
+		// --- Destructor ---
+
+		~ObjectPool() = default;	// Chunks are returned wholesale, objects still acquired are not destroyed
+
+		// --- Pool functions (not synchronized, threads sharing a pool should go through their own LocalCache) ---
+
+		template <typename... Args>
+		T* Acquire(Args&&... args) {
+			if (free_head_ == nullptr) { Grow(); }
+			Node* node = free_head_;
+			free_head_ = node->next;							// unlink first, the object overwrites the link
+			try {
+				return new (node->storage) T(std::forward<Args>(args)...);
+			}
+			catch (...) {
+				Push(node);										// in case of throwing exception, give the slot back
+				throw;
+			}
+		}
+
+		void Release(T* object) noexcept {
+			if (object == nullptr) { return; }
+			std::destroy_at(object);
+			Push(reinterpret_cast<Node*>(object));
+		}
+
+		size_t Capacity() const noexcept { return capacity_; }		// Total number of slots in all chunks
+
+		void Reserve(size_t new_capacity) {							// Make sure the pool holds at least new_capacity slots
+			if (new_capacity > capacity_) {
+				next_chunk_size_ = std::max(next_chunk_size_, new_capacity - capacity_);
+				Grow();
+			}
+		}
+
+	private:
+
+		void Push(Node* node) noexcept {		// Put a slot to the intrusive free list
+			node->next = free_head_;
+			free_head_ = node;
+		}
+
+		void Grow() {							// Allocate a new chunk and thread all of its slots to the free list
+			RawMemory<Node> chunk(next_chunk_size_);
+			chunks_.PushBack(std::move(chunk));	// chunks never move their memory, live objects stay in place
+			RawMemory<Node>& added = chunks_[chunks_.Size() - 1];
+			for (size_t i = added.Capacity(); i > 0; --i) {
+				Push(added + (i - 1));
+			}
+			capacity_ += added.Capacity();
+			next_chunk_size_ *= 2;				// raw memory increase factor like in Vector
+		}
+
+		Vector<RawMemory<Node>> chunks_;	// Allocated raw memory
+		Node* free_head_ = nullptr;			// Head of the intrusive free list
+		size_t capacity_ = 0;
+		size_t next_chunk_size_;
+		std::mutex mutex_;					// Guards the pool when accessed through LocalCache
+};
+
+template <typename T>
+class ObjectPool<T>::LocalCache {
+
+	public:
+
+		// --- Constructors ---
+
+		explicit LocalCache(ObjectPool& pool, size_t batch_size = 32)
+			: pool_(pool)
+			, batch_size_(batch_size == 0 ? 1 : batch_size)
+		{}
+
+		LocalCache(const LocalCache&) = delete;
+		LocalCache& operator=(const LocalCache&) = delete;
+
+		// --- Destructor ---
+
+		~LocalCache() { Flush(0); }		// Return every cached slot to the shared pool
+
+		// --- Cache functions (one cache per thread) ---
+
+		template <typename... Args>
+		T* Acquire(Args&&... args) {
+			if (head_ == nullptr) { Refill(); }
+			Node* node = head_;
+			head_ = node->next;									// unlink first, the object overwrites the link
+			--count_;
+			try {
+				return new (node->storage) T(std::forward<Args>(args)...);
+			}
+			catch (...) {
+				node->next = head_;								// in case of throwing exception, give the slot back
+				head_ = node;
+				++count_;
+				throw;
+			}
+		}
+
+		void Release(T* object) noexcept {
+			if (object == nullptr) { return; }
+			std::destroy_at(object);
+			Node* node = reinterpret_cast<Node*>(object);
+			node->next = head_;
+			head_ = node;
+			if (++count_ > 2 * batch_size_) { Flush(batch_size_); }	// keep the cache bounded
+		}
+
+		size_t Cached() const noexcept { return count_; }
+
+	private:
+
+		void Refill() {								// Take a batch of slots from the shared pool under the lock
+			std::lock_guard lock(pool_.mutex_);
+			for (size_t i = 0; i < batch_size_; ++i) {
+				if (pool_.free_head_ == nullptr) { pool_.Grow(); }
+				Node* node = pool_.free_head_;
+				pool_.free_head_ = node->next;
+				node->next = head_;
+				head_ = node;
+				++count_;
+			}
+		}
+
+		void Flush(size_t keep) noexcept {			// Give cached slots back to the shared pool, leaving keep of them
+			if (count_ <= keep) { return; }
+			std::lock_guard lock(pool_.mutex_);
+			while (count_ > keep) {
+				Node* node = head_;
+				head_ = node->next;
+				pool_.Push(node);
+				--count_;
+			}
+		}
+
+		ObjectPool& pool_;
+		size_t batch_size_;
+		Node* head_ = nullptr;	// Thread-private free list
+		size_t count_ = 0;
+};
@@ -0,0 +1,309 @@
+#pragma once
+
+#include "vector.h"
+#include "devector.h"
+#include "cache_line.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+class ThreadPool {	// Work-stealing pool: each worker pops its own queue from the back, idle workers steal from the front of others
+
+	struct alignas(CACHE_LINE_SIZE) WorkerQueue {
+		std::mutex mutex;
+		Devector<std::function<void()>> tasks;
+	};
+
+	struct Identity {			// Which pool and queue the current thread works for
+		const ThreadPool* pool;
+		size_t index;
+	};
+
+	public:
+
+		// --- Constructors ---
+
+		explicit ThreadPool(size_t thread_count = DefaultThreadCount()) {
+			assert(thread_count > 0);
+			queues_.Reserve(thread_count);
+			for (size_t i = 0; i < thread_count; ++i) { queues_.EmplaceBack(std::make_unique<WorkerQueue>()); }
+			threads_.Reserve(thread_count);
+			for (size_t i = 0; i < thread_count; ++i) { threads_.EmplaceBack([this, i] { WorkerLoop(i); }); }
+		}
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		// --- Destructor ---
+
+		~ThreadPool() {		// Runs every task already submitted, then joins
+			{
+				std::lock_guard lock(sleep_mutex_);
+				stop_ = true;
+			}
+			wake_.notify_all();
+			for (std::thread& thread : threads_) { thread.join(); }
+		}
+
+		// --- Tasks ---
+
+		static size_t DefaultThreadCount() noexcept {
+			size_t hardware = std::thread::hardware_concurrency();
+			return hardware > 1 ? hardware - 1 : 1;		// the thread waiting on the result works too
+		}
+
+		static ThreadPool& Shared() {	// Process-wide pool, created on first use
+			static ThreadPool pool;
+			return pool;
+		}
+
+		size_t ThreadCount() const noexcept { return threads_.Size(); }
+
+		void Submit(std::function<void()> task) {	// A worker pushes to its own queue, other threads spread tasks round-robin
+			size_t index = current_.pool == this
+				? current_.index
+				: next_queue_.fetch_add(1, std::memory_order_relaxed) % queues_.Size();
+			{
+				std::lock_guard lock(queues_[index]->mutex);
+				queues_[index]->tasks.PushBack(std::move(task));
+				pending_.fetch_add(1, std::memory_order_release);	// before the unlock - a thief's fetch_sub must not wrap the counter
+			}
+			{
+				std::lock_guard lock(sleep_mutex_);		// a worker between its check and its wait cannot miss this notify
+			}
+			wake_.notify_one();
+		}
+
+		bool RunOneTask() {		// Helps from a waiting thread, false if every queue was empty
+			std::function<void()> task;
+			size_t home = current_.pool == this ? current_.index : 0;
+			if (!TryTake(home, task)) { return false; }
+			task();
+			return true;
+		}
+
+	private:
+
+		bool TryTake(size_t home, std::function<void()>& task) {
+			{
+				WorkerQueue& own = *queues_[home];
+				std::lock_guard lock(own.mutex);
+				if (own.tasks.Size() > 0) {		// LIFO on the own queue - the freshest task is hot in cache
+					task = std::move(*(own.tasks.end() - 1));
+					own.tasks.PopBack();
+					pending_.fetch_sub(1, std::memory_order_relaxed);
+					return true;
+				}
+			}
+			for (size_t offset = 1; offset < queues_.Size(); ++offset) {
+				WorkerQueue& victim = *queues_[(home + offset) % queues_.Size()];
+				std::lock_guard lock(victim.mutex);
+				if (victim.tasks.Size() > 0) {	// FIFO when stealing - the oldest task is usually the biggest
+					task = std::move(*victim.tasks.begin());
+					victim.tasks.PopFront();
+					pending_.fetch_sub(1, std::memory_order_relaxed);
+					return true;
+				}
+			}
+			return false;
+		}
+
+		void WorkerLoop(size_t index) {
+			current_ = Identity{ this, index };
+			while (true) {
+				std::function<void()> task;
+				if (TryTake(index, task)) {
+					task();
+					continue;
+				}
+				std::unique_lock lock(sleep_mutex_);
+				wake_.wait(lock, [this] { return stop_ || pending_.load(std::memory_order_acquire) > 0; });
+				if (stop_ && pending_.load(std::memory_order_acquire) == 0) { return; }
+			}
+		}
+
+		inline static thread_local Identity current_{ nullptr, 0 };
+
+		Vector<std::unique_ptr<WorkerQueue>> queues_;
+		Vector<std::thread> threads_;
+		std::atomic<size_t> next_queue_{ 0 };
+		std::atomic<size_t> pending_{ 0 };		// Tasks sitting in queues
+		std::mutex sleep_mutex_;
+		std::condition_variable wake_;
+		bool stop_ = false;
+};
+
+class TaskGroup {	// Fork-join over a pool, Wait() runs queued tasks and blocks only once every queue is empty
+
+	public:
+
+		explicit TaskGroup(ThreadPool& pool = ThreadPool::Shared()) noexcept : pool_(pool) {}
+
+		TaskGroup(const TaskGroup&) = delete;
+		TaskGroup& operator=(const TaskGroup&) = delete;
+
+		~TaskGroup() { WaitAll(); }
+
+		template <typename Function>
+		void Run(Function function) {
+			remaining_.fetch_add(1, std::memory_order_relaxed);
+			pool_.Submit([this, function = std::move(function)]() mutable {
+				try {
+					function();
+				}
+				catch (...) {
+					std::lock_guard lock(error_mutex_);
+					if (error_ == nullptr) { error_ = std::current_exception(); }
+				}
+				std::lock_guard lock(done_mutex_);		// the waiter cannot destroy the group while the last task still notifies
+				if (remaining_.fetch_sub(1, std::memory_order_release) == 1) { done_.notify_all(); }
+			});
+		}
+
+		void Wait() {	// Rethrows the first exception thrown by a task
+			WaitAll();
+			if (error_ != nullptr) { std::rethrow_exception(std::exchange(error_, nullptr)); }
+		}
+
+	private:
+
+		void WaitAll() noexcept {
+			while (remaining_.load(std::memory_order_acquire) != 0) {
+				if (pool_.RunOneTask()) { continue; }
+				std::unique_lock lock(done_mutex_);		// the rest is running on other threads
+				done_.wait(lock, [this] { return remaining_.load(std::memory_order_acquire) == 0; });
+			}
+			std::lock_guard lock(done_mutex_);			// the task that reached 0 has left its notify
+		}
+
+		ThreadPool& pool_;
+		std::atomic<size_t> remaining_{ 0 };
+		std::mutex done_mutex_;
+		std::condition_variable done_;
+		std::mutex error_mutex_;
+		std::exception_ptr error_;
+};
+
+enum class ReduceOrder {
+	FAST,			// Partials combine as tasks finish, op must be associative and commutative
+	DETERMINISTIC	// Partition depends on the size only and partials combine left to right - same result on every run
+};
+
+inline constexpr size_t AUTO_GRAIN = 0;
+
+namespace parallel_detail {
+
+	inline constexpr std::chrono::nanoseconds TARGET_TASK_TIME{ 100'000 };	// Long enough to hide the scheduling cost of a task
+	inline constexpr std::chrono::nanoseconds PROBE_TIME{ 20'000 };
+	inline constexpr size_t TASKS_PER_THREAD = 4;								// Slack for load balancing
+	inline constexpr size_t DETERMINISTIC_GRAIN = 4096;
+
+	template <typename Body>
+	size_t TuneGrain(size_t size, size_t threads, Body& body, size_t& done) {	// Runs the first elements inline, timing doubling batches
+		size_t probe_limit = size / 8;
+		size_t batch = 16;
+		auto elapsed = std::chrono::nanoseconds::zero();
+		size_t measured = 0;
+		while (done < probe_limit && elapsed < PROBE_TIME) {
+			size_t end = std::min(done + batch, probe_limit);
+			auto start = std::chrono::steady_clock::now();
+			body(done, end);
+			elapsed = std::chrono::steady_clock::now() - start;
+			measured = end - done;
+			done = end;
+			batch *= 2;
+		}
+		size_t remaining = size - done;
+		size_t balanced = std::max<size_t>(1, remaining / (threads * TASKS_PER_THREAD));
+		if (measured == 0 || elapsed.count() == 0) { return balanced; }
+		size_t grain = static_cast<size_t>(TARGET_TASK_TIME.count() * static_cast<double>(measured) / elapsed.count());
+		return std::clamp<size_t>(grain, 1, balanced);
+	}
+
+}  // namespace parallel_detail
+
+template <typename Body>
+void ParallelFor(size_t size, Body body, size_t grain = AUTO_GRAIN, ThreadPool& pool = ThreadPool::Shared()) {	// body(begin, end) over [0, size)
+	size_t begin = 0;
+	if (grain == AUTO_GRAIN) { grain = parallel_detail::TuneGrain(size, pool.ThreadCount() + 1, body, begin); }
+	if (size - begin <= grain) {
+		if (begin < size) { body(begin, size); }
+		return;
+	}
+	TaskGroup group(pool);
+	for (; begin < size; begin += grain) {
+		size_t end = std::min(size, begin + grain);
+		group.Run([&body, begin, end] { body(begin, end); });
+	}
+	group.Wait();
+}
+
+template <typename T, typename Function>
+void ParallelForEach(Span<T> range, Function function, size_t grain = AUTO_GRAIN, ThreadPool& pool = ThreadPool::Shared()) {
+	ParallelFor(range.Size(), [range, &function](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i) { function(range[i]); }
+	}, grain, pool);
+}
+
+template <typename T, typename Allocator, typename Function>
+void ParallelForEach(Vector<T, Allocator>& vector, Function function, size_t grain = AUTO_GRAIN, ThreadPool& pool = ThreadPool::Shared()) {
+	ParallelForEach(vector.AsSpan(), std::move(function), grain, pool);
+}
+
+template <typename T, typename U, typename Function>
+void ParallelTransform(Span<const T> input, Span<U> output, Function function, size_t grain = AUTO_GRAIN, ThreadPool& pool = ThreadPool::Shared()) {
+	assert(input.Size() == output.Size());
+	ParallelFor(input.Size(), [input, output, &function](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i) { output[i] = function(input[i]); }
+	}, grain, pool);
+}
+
+template <typename T, typename Allocator, typename Function>
+auto ParallelTransform(const Vector<T, Allocator>& input, Function function, size_t grain = AUTO_GRAIN, ThreadPool& pool = ThreadPool::Shared()) {	// Result type must be default constructible
+	using Result = std::decay_t<std::invoke_result_t<Function&, const T&>>;
+	Vector<Result> output(input.Size());
+	ParallelTransform(input.AsSpan(), output.AsSpan(), std::move(function), grain, pool);
+	return output;
+}
+
+template <typename T, typename Op>
+T ParallelReduce(Span<const T> range, T init, Op op, ReduceOrder order = ReduceOrder::FAST, ThreadPool& pool = ThreadPool::Shared()) {
+	auto reduce_range = [range, &op](size_t begin, size_t end) {	// non-empty range, no identity element needed
+		T accumulator = range[begin];
+		for (size_t i = begin + 1; i < end; ++i) { accumulator = op(std::move(accumulator), range[i]); }
+		return accumulator;
+	};
+	if (order == ReduceOrder::DETERMINISTIC) {
+		size_t grain = std::max(parallel_detail::DETERMINISTIC_GRAIN, range.Size() / 256);
+		size_t chunks = (range.Size() + grain - 1) / grain;
+		Vector<std::optional<T>> partials(chunks);
+		ParallelFor(chunks, [&](size_t begin, size_t end) {
+			for (size_t chunk = begin; chunk < end; ++chunk) {
+				partials[chunk] = reduce_range(chunk * grain, std::min(range.Size(), (chunk + 1) * grain));
+			}
+		}, 1, pool);
+		for (std::optional<T>& partial : partials) { init = op(std::move(init), std::move(*partial)); }
+		return init;
+	}
+	std::mutex mutex;
+	std::optional<T> total;
+	ParallelFor(range.Size(), [&](size_t begin, size_t end) {
+		T partial = reduce_range(begin, end);
+		std::lock_guard lock(mutex);
+		total = total.has_value() ? op(std::move(*total), std::move(partial)) : std::move(partial);
+	}, AUTO_GRAIN, pool);
+	return total.has_value() ? op(std::move(init), std::move(*total)) : init;
+}
+
+template <typename T, typename Allocator, typename Op>
+T ParallelReduce(const Vector<T, Allocator>& vector, T init, Op op, ReduceOrder order = ReduceOrder::FAST, ThreadPool& pool = ThreadPool::Shared()) {
+	return ParallelReduce(vector.AsSpan(), std::move(init), std::move(op), order, pool);
+}
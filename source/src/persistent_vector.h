@@ -0,0 +1,436 @@
+#pragma once
+
+#include "vector.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+template <typename T>
+class PersistentVector {	// Immutable radix tree with 32-way nodes, updates copy one path and share the rest
+
+	static constexpr size_t BITS = 5;
+	static constexpr size_t WIDTH = size_t{ 1 } << BITS;	// 32 children or values per node
+	static constexpr size_t EXTRA = 2;						// Concat keeps at most this many nodes above the optimum per level
+
+	struct Node {
+		size_t size = 0;							// Elements in the subtree
+		Vector<std::shared_ptr<Node>> children;		// Inner node
+		Vector<T> values;							// Leaf
+		Vector<size_t> sizes;						// Cumulative child sizes, empty for a regular node whose children but the last are full
+		uint64_t edit = 0;							// Transient allowed to modify the node in place, 0 - nobody
+	};
+
+	using NodePtr = std::shared_ptr<Node>;
+
+	public:
+
+		class Transient;
+
+		// --- Constructors ---
+
+		PersistentVector() = default;
+
+		static PersistentVector FromVector(const Vector<T>& elements) {	// Bulk build through a transient, nodes are filled in place
+			Transient transient;
+			for (const T& element : elements) { transient.PushBack(element); }
+			return transient.Persistent();
+		}
+
+		// --- Operators overloads ---
+
+		const T& operator[](size_t index) const noexcept {	// O(log32 N)
+			assert(index < size_);
+			return Get(root_, height_, index);
+		}
+
+		// --- Persistent functions (return a new version, this one is unchanged) ---
+
+		size_t Size()   const noexcept { return size_; }
+		size_t Height() const noexcept { return height_; }	// Levels above the leaves, 0 - the root is a leaf
+
+		[[nodiscard]] PersistentVector Set(size_t index, T value) const {
+			assert(index < size_);
+			return PersistentVector(SetIn(root_, height_, index, std::move(value), 0), height_, size_);
+		}
+
+		[[nodiscard]] PersistentVector PushBack(T value) const {
+			PersistentVector result(*this);
+			result.Append(std::move(value), 0);
+			return result;
+		}
+
+		[[nodiscard]] PersistentVector Concat(const PersistentVector& other) const {	// Merges the two trees along the seam, O(log N) new nodes
+			if (size_ == 0)       { return other; }
+			if (other.size_ == 0) { return *this; }
+			Vector<NodePtr> roots = Merge(root_, height_, other.root_, other.height_);
+			size_t height = std::max(height_, other.height_);
+			if (roots.Size() == 1) { return PersistentVector(roots[0], height, size_ + other.size_); }
+			NodePtr root = std::make_shared<Node>();
+			for (NodePtr& node : roots) { root->children.PushBack(std::move(node)); }
+			Finalize(*root, height + 1);
+			return PersistentVector(root, height + 1, size_ + other.size_);
+		}
+
+		[[nodiscard]] PersistentVector Slice(size_t begin, size_t end) const {	// Elements [begin, end), O(log N) new nodes
+			assert(begin <= end && end <= size_);
+			if (begin == end) { return PersistentVector(); }
+			NodePtr root = Drop(Take(root_, height_, end), height_, begin);
+			size_t height = height_;
+			while (height > 0 && root->children.Size() == 1) {	// drop levels left with a single child
+				root = root->children[0];
+				--height;
+			}
+			return PersistentVector(root, height, end - begin);
+		}
+
+		[[nodiscard]] Transient AsTransient() const { return Transient(*this); }
+
+		Vector<T> ToVector() const {
+			Vector<T> result;
+			result.Reserve(size_);
+			ForEach([&result](const T& value) { result.PushBack(value); });
+			return result;
+		}
+
+		template <typename Function>
+		void ForEach(Function function) const {		// In-order walk, leaves are visited as contiguous arrays
+			if (root_ != nullptr) { Walk(*root_, function); }
+		}
+
+	private:
+
+		PersistentVector(NodePtr root, size_t height, size_t size)
+			: root_(std::move(root))
+			, height_(height)
+			, size_(size)
+		{}
+
+		static size_t Shift(size_t height) noexcept { return BITS * (height + 1); }
+
+		static size_t Capacity(size_t height) noexcept {	// Elements in a full subtree, saturates where it no longer fits a size_t
+			return Shift(height) < 64 ? size_t{ 1 } << Shift(height) : SIZE_MAX;
+		}
+
+		static uint64_t NewEditToken() noexcept {	// Never reused, so an old token cannot unlock nodes for a new transient
+			static std::atomic<uint64_t> next{ 1 };
+			return next.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		static size_t FindChild(const Node& node, size_t child_height, size_t& index) noexcept {	// Picks the child holding index and makes index local to it
+			size_t shift = Shift(child_height);
+			size_t child = shift < 64 ? index >> shift : 0;
+			if (node.sizes.Size() == 0) {
+				index -= child == 0 ? 0 : child << shift;
+				return child;
+			}
+			if (child >= node.sizes.Size()) { child = node.sizes.Size() - 1; }
+			while (child > 0 && node.sizes[child - 1] > index) { --child; }
+			while (node.sizes[child] <= index) { ++child; }
+			index -= child == 0 ? 0 : node.sizes[child - 1];
+			return child;
+		}
+
+		static const T& Get(const NodePtr& root, size_t height, size_t index) noexcept {
+			const Node* node = root.get();
+			for (size_t h = height; h > 0; --h) {
+				node = node->children[FindChild(*node, h - 1, index)].get();
+			}
+			return node->values[index];
+		}
+
+		static void Finalize(Node& node, size_t height) {	// Recompute size and decide whether a size table is needed
+			node.sizes = Vector<size_t>();
+			if (height == 0) {
+				node.size = node.values.Size();
+				return;
+			}
+			node.size = 0;
+			bool regular = true;
+			for (size_t i = 0; i < node.children.Size(); ++i) {
+				node.size += node.children[i]->size;
+				if (i + 1 < node.children.Size() && node.children[i]->size != Capacity(height - 1)) { regular = false; }
+			}
+			if (!regular) { BuildSizes(node); }
+		}
+
+		static void BuildSizes(Node& node) {
+			node.sizes.Reserve(WIDTH);
+			size_t total = 0;
+			for (const NodePtr& child : node.children) {
+				total += child->size;
+				node.sizes.PushBack(total);
+			}
+		}
+
+		static NodePtr Editable(const NodePtr& node, uint64_t edit) {	// The node itself for its own transient, a copy otherwise
+			if (edit != 0 && node->edit == edit) { return node; }
+			NodePtr copy = std::make_shared<Node>(*node);
+			copy->edit = edit;
+			return copy;
+		}
+
+		static NodePtr Wrap(NodePtr child) {
+			NodePtr node = std::make_shared<Node>();
+			node->size = child->size;
+			node->children.PushBack(std::move(child));
+			return node;
+		}
+
+		// --- Concatenation (RRB): merge down the seam, then rebalance each level on the way up ---
+
+		static size_t SlotCount(const Node& node, size_t height) noexcept { return height == 0 ? node.values.Size() : node.children.Size(); }
+
+		static Vector<NodePtr> Merge(const NodePtr& left, size_t left_height, const NodePtr& right, size_t right_height) {
+			// Nodes of height max(left_height, right_height) holding left's elements followed by right's
+			if (left_height == 0 && right_height == 0) {
+				Vector<NodePtr> leaves;
+				leaves.PushBack(left);
+				leaves.PushBack(right);
+				return Rebalance(std::move(leaves), 0);
+			}
+			size_t height = std::max(left_height, right_height);
+			Vector<NodePtr> children;		// height - 1, at most 2 * WIDTH of them
+			if (left_height == height) {
+				for (size_t i = 0; i + 1 < left->children.Size(); ++i) { children.PushBack(left->children[i]); }
+			}
+			Vector<NodePtr> middle = Merge(
+				left_height == height ? left->children[left->children.Size() - 1] : left, std::min(left_height, height - 1),
+				right_height == height ? right->children[0] : right, std::min(right_height, height - 1));
+			for (NodePtr& node : middle) { children.PushBack(std::move(node)); }
+			if (right_height == height) {
+				for (size_t i = 1; i < right->children.Size(); ++i) { children.PushBack(right->children[i]); }
+			}
+			children = Rebalance(std::move(children), height - 1);
+
+			Vector<NodePtr> result;
+			for (size_t first = 0; first < children.Size(); first += WIDTH) {
+				NodePtr node = std::make_shared<Node>();
+				for (size_t i = first; i < children.Size() && i < first + WIDTH; ++i) { node->children.PushBack(std::move(children[i])); }
+				Finalize(*node, height);
+				result.PushBack(std::move(node));
+			}
+			return result;
+		}
+
+		static Vector<NodePtr> Rebalance(Vector<NodePtr> nodes, size_t height) {
+			// Squeezes the slots of nodes (all of one height) into at most optimal + EXTRA nodes, which bounds the tree height.
+			// Nodes that are already dense are skipped, and a node that keeps exactly its slots is shared, not copied.
+			Vector<size_t> counts;
+			size_t total = 0;
+			for (const NodePtr& node : nodes) {
+				counts.PushBack(SlotCount(*node, height));
+				total += counts[counts.Size() - 1];
+			}
+			size_t optimal = (total + WIDTH - 1) / WIDTH;
+			size_t count = counts.Size();
+			if (count <= optimal + EXTRA) { return nodes; }
+
+			for (size_t i = 0; count > optimal + EXTRA;) {
+				while (counts[i] >= WIDTH - EXTRA / 2) { ++i; }
+				size_t remaining = counts[i];		// spread node i over the nodes after it
+				while (remaining > 0) {
+					assert(i + 1 < count);
+					size_t merged = std::min(remaining + counts[i + 1], WIDTH);
+					remaining = remaining + counts[i + 1] - merged;
+					counts[i] = merged;
+					++i;
+				}
+				for (size_t j = i; j + 1 < count; ++j) { counts[j] = counts[j + 1]; }
+				--count;
+				--i;
+			}
+
+			Vector<NodePtr> result;
+			result.Reserve(count);
+			size_t source = 0;
+			size_t offset = 0;		// slots of nodes[source] already taken
+			for (size_t planned = 0; planned < count; ++planned) {
+				if (offset == 0 && SlotCount(*nodes[source], height) == counts[planned]) {
+					result.PushBack(nodes[source++]);
+					continue;
+				}
+				NodePtr node = std::make_shared<Node>();
+				for (size_t filled = 0; filled < counts[planned];) {
+					const Node& from = *nodes[source];
+					size_t take = std::min(counts[planned] - filled, SlotCount(from, height) - offset);
+					for (size_t i = offset; i < offset + take; ++i) {
+						if (height == 0) { node->values.PushBack(from.values[i]); }
+						else             { node->children.PushBack(from.children[i]); }
+					}
+					filled += take;
+					offset += take;
+					if (offset == SlotCount(from, height)) {
+						++source;
+						offset = 0;
+					}
+				}
+				Finalize(*node, height);
+				result.PushBack(std::move(node));
+			}
+			assert(source == nodes.Size());
+			return result;
+		}
+
+		static NodePtr NewPath(size_t height, T&& value, uint64_t edit) {
+			NodePtr node = std::make_shared<Node>();
+			node->edit = edit;
+			node->values.Reserve(WIDTH);
+			node->values.PushBack(std::move(value));
+			node->size = 1;
+			for (size_t h = 0; h < height; ++h) {
+				node = Wrap(std::move(node));
+				node->edit = edit;
+			}
+			return node;
+		}
+
+		static NodePtr SetIn(const NodePtr& node, size_t height, size_t index, T&& value, uint64_t edit) {
+			NodePtr result = Editable(node, edit);
+			if (height == 0) {
+				result->values[index] = std::move(value);
+				return result;
+			}
+			size_t child = FindChild(*node, height - 1, index);
+			result->children[child] = SetIn(node->children[child], height - 1, index, std::move(value), edit);
+			return result;
+		}
+
+		static NodePtr AppendIn(const NodePtr& node, size_t height, T& value, uint64_t edit) {	// nullptr if the right edge has no room
+			if (height == 0) {
+				if (node->values.Size() == WIDTH) { return nullptr; }
+				NodePtr result = Editable(node, edit);
+				result->values.PushBack(std::move(value));
+				++result->size;
+				return result;
+			}
+			size_t last = node->children.Size() - 1;
+			if (NodePtr child = AppendIn(node->children[last], height - 1, value, edit)) {
+				NodePtr result = Editable(node, edit);
+				result->children[last] = std::move(child);
+				++result->size;
+				if (result->sizes.Size() != 0) { ++result->sizes[last]; }
+				return result;
+			}
+			if (node->children.Size() == WIDTH) { return nullptr; }
+			NodePtr result = Editable(node, edit);
+			if (result->sizes.Size() == 0 && result->children[last]->size != Capacity(height - 1)) { BuildSizes(*result); }	// a non-full child is no longer last
+			result->children.PushBack(NewPath(height - 1, std::move(value), edit));
+			++result->size;
+			if (result->sizes.Size() != 0) { result->sizes.PushBack(result->size); }
+			return result;
+		}
+
+		void Append(T&& value, uint64_t edit) {
+			if (root_ == nullptr) {
+				root_ = NewPath(0, std::move(value), edit);
+			}
+			else if (NodePtr root = AppendIn(root_, height_, value, edit)) {
+				root_ = std::move(root);
+			}
+			else {		// the tree is full along its right edge - grow by one level
+				NodePtr new_root = std::make_shared<Node>();
+				new_root->edit = edit;
+				new_root->children.PushBack(root_);
+				new_root->children.PushBack(NewPath(height_, std::move(value), edit));
+				Finalize(*new_root, height_ + 1);
+				root_ = std::move(new_root);
+				++height_;
+			}
+			++size_;
+		}
+
+		static NodePtr Take(const NodePtr& node, size_t height, size_t count) {	// First count elements, 0 < count <= size
+			if (count == node->size) { return node; }
+			NodePtr result = std::make_shared<Node>();
+			if (height == 0) {
+				for (size_t i = 0; i < count; ++i) { result->values.PushBack(node->values[i]); }
+			}
+			else {
+				size_t local = count - 1;
+				size_t child = FindChild(*node, height - 1, local);
+				for (size_t i = 0; i < child; ++i) { result->children.PushBack(node->children[i]); }
+				result->children.PushBack(Take(node->children[child], height - 1, local + 1));
+			}
+			Finalize(*result, height);
+			return result;
+		}
+
+		static NodePtr Drop(const NodePtr& node, size_t height, size_t count) {	// All but the first count elements, count < size
+			if (count == 0) { return node; }
+			NodePtr result = std::make_shared<Node>();
+			if (height == 0) {
+				for (size_t i = count; i < node->values.Size(); ++i) { result->values.PushBack(node->values[i]); }
+			}
+			else {
+				size_t local = count;
+				size_t child = FindChild(*node, height - 1, local);
+				result->children.PushBack(Drop(node->children[child], height - 1, local));
+				for (size_t i = child + 1; i < node->children.Size(); ++i) { result->children.PushBack(node->children[i]); }
+			}
+			Finalize(*result, height);
+			return result;
+		}
+
+		template <typename Function>
+		static void Walk(const Node& node, Function& function) {
+			for (const T& value : node.values) { function(value); }
+			for (const NodePtr& child : node.children) { Walk(*child, function); }
+		}
+
+		NodePtr root_;			// nullptr for an empty vector
+		size_t height_ = 0;		// 0 - the root is a leaf
+		size_t size_ = 0;
+};
+
+template <typename T>
+class PersistentVector<T>::Transient {	// Batch-mutable builder, nodes it created are changed in place until Persistent()
+
+	public:
+
+		Transient() : edit_(NewEditToken()) {}
+
+		explicit Transient(const PersistentVector& base)
+			: vector_(base)
+			, edit_(NewEditToken())
+		{}
+
+		Transient(const Transient&) = delete;				// a copy would share the edit token and mutate the same nodes
+		Transient& operator=(const Transient&) = delete;
+
+		Transient(Transient&& other) noexcept
+			: vector_(std::exchange(other.vector_, PersistentVector()))
+			, edit_(std::exchange(other.edit_, NewEditToken()))	// the moved-from builder can no longer touch our nodes
+		{}
+
+		Transient& operator=(Transient&& rhs) noexcept {
+			if (this != &rhs) {
+				vector_ = std::exchange(rhs.vector_, PersistentVector());
+				edit_ = std::exchange(rhs.edit_, NewEditToken());
+			}
+			return *this;
+		}
+
+		size_t Size() const noexcept { return vector_.Size(); }
+
+		const T& operator[](size_t index) const noexcept { return vector_[index]; }
+
+		void PushBack(T value) { vector_.Append(std::move(value), edit_); }
+
+		void Set(size_t index, T value) {
+			assert(index < Size());
+			vector_.root_ = SetIn(vector_.root_, vector_.height_, index, std::move(value), edit_);
+		}
+
+		[[nodiscard]] PersistentVector Persistent() {	// Freeze the result, later edits of this builder copy nodes again
+			edit_ = NewEditToken();
+			return vector_;
+		}
+
+	private:
+
+		PersistentVector vector_;
+		uint64_t edit_;
+};
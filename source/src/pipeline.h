@@ -0,0 +1,274 @@
+#pragma once
+
+#include "vector.h"
+
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+
+// Lazy pipelines: Pipe(v).Filter(p).Map(f).Take(n).Collect() runs as one loop over v.
+// Stages are push-based - each one hands its values straight to the next stage's sink, and
+// a sink returning false stops the source early. Nothing is materialized until a terminal
+// operation (ForEach, Count, Collect) runs. Collect allocates its result, Chunk one reusable buffer, nothing else does.
+// Every stage also states whether its SizeHint is tight (no Filter can shrink the output below it, or a Take caps it)
+// and whether its values borrow a buffer of the pipeline (Chunk spans), which Collect must not keep.
+
+namespace pipeline_detail {
+
+	template <typename T>
+	class SpanSource {
+
+		public:
+
+			static constexpr bool TIGHT_HINT = true;
+			static constexpr bool BORROWS_BUFFER = false;
+
+			explicit SpanSource(Span<const T> span) noexcept : span_(span) {}
+
+			template <typename Sink>
+			bool Run(Sink&& sink) const {	// false - a sink asked to stop
+				for (const T& value : span_) {
+					if (!sink(value)) { return false; }
+				}
+				return true;
+			}
+
+			size_t SizeHint() const noexcept { return span_.Size(); }	// Upper bound of the elements produced
+
+		private:
+
+			Span<const T> span_;
+	};
+
+	template <typename Previous, typename Function>
+	class MapStage {
+
+		public:
+
+			static constexpr bool TIGHT_HINT = Previous::TIGHT_HINT;
+			static constexpr bool BORROWS_BUFFER = false;		// the function builds a new value
+
+			MapStage(Previous previous, Function function) : previous_(std::move(previous)), function_(std::move(function)) {}
+
+			template <typename Sink>
+			bool Run(Sink&& sink) const {
+				return previous_.Run([&](auto&& value) { return sink(function_(std::forward<decltype(value)>(value))); });
+			}
+
+			size_t SizeHint() const noexcept { return previous_.SizeHint(); }
+
+		private:
+
+			Previous previous_;
+			Function function_;
+	};
+
+	template <typename Previous, typename Predicate>
+	class FilterStage {
+
+		public:
+
+			static constexpr bool TIGHT_HINT = false;			// the hint still counts the values that are dropped
+			static constexpr bool BORROWS_BUFFER = Previous::BORROWS_BUFFER;
+
+			FilterStage(Previous previous, Predicate predicate) : previous_(std::move(previous)), predicate_(std::move(predicate)) {}
+
+			template <typename Sink>
+			bool Run(Sink&& sink) const {
+				return previous_.Run([&](auto&& value) { return predicate_(value) ? sink(std::forward<decltype(value)>(value)) : true; });
+			}
+
+			size_t SizeHint() const noexcept { return previous_.SizeHint(); }
+
+		private:
+
+			Previous previous_;
+			Predicate predicate_;
+	};
+
+	template <typename Previous>
+	class TakeStage {
+
+		public:
+
+			static constexpr bool TIGHT_HINT = true;			// at most count, a bound the caller chose
+			static constexpr bool BORROWS_BUFFER = Previous::BORROWS_BUFFER;
+
+			TakeStage(Previous previous, size_t count) : previous_(std::move(previous)), count_(count) {}
+
+			template <typename Sink>
+			bool Run(Sink&& sink) const {
+				if (count_ == 0) { return true; }
+				size_t remaining = count_;
+				bool stopped = false;
+				previous_.Run([&](auto&& value) {
+					stopped = !sink(std::forward<decltype(value)>(value));
+					return !stopped && --remaining > 0;		// stops the source as soon as enough values passed
+				});
+				return !stopped;
+			}
+
+			size_t SizeHint() const noexcept { return std::min(count_, previous_.SizeHint()); }
+
+		private:
+
+			Previous previous_;
+			size_t count_;
+	};
+
+	template <typename Previous, typename U>
+	class ZipStage {	// Pairs the i-th value that reaches this stage with other[i]
+
+		public:
+
+			static constexpr bool TIGHT_HINT = Previous::TIGHT_HINT;
+			static constexpr bool BORROWS_BUFFER = Previous::BORROWS_BUFFER;
+
+			ZipStage(Previous previous, Span<const U> other) : previous_(std::move(previous)), other_(other) {}
+
+			template <typename Sink>
+			bool Run(Sink&& sink) const {
+				if (other_.Empty()) { return true; }
+				size_t index = 0;
+				bool stopped = false;
+				previous_.Run([&](auto&& value) {
+					using Value = std::decay_t<decltype(value)>;
+					stopped = !sink(std::pair<Value, U>(std::forward<decltype(value)>(value), other_[index]));
+					return !stopped && ++index < other_.Size();
+				});
+				return !stopped;
+			}
+
+			size_t SizeHint() const noexcept { return std::min(other_.Size(), previous_.SizeHint()); }
+
+		private:
+
+			Previous previous_;
+			Span<const U> other_;
+	};
+
+	template <typename Previous, typename Value>
+	class ChunkStage {	// Groups values into Span<const Value> of up to size elements, the span is valid inside the sink only
+
+		public:
+
+			static constexpr bool TIGHT_HINT = Previous::TIGHT_HINT;
+			static constexpr bool BORROWS_BUFFER = true;
+
+			ChunkStage(Previous previous, size_t size) : previous_(std::move(previous)), size_(size) { assert(size != 0); }
+
+			template <typename Sink>
+			bool Run(Sink&& sink) const {
+				Vector<Value> buffer;	// the only allocation of a pipeline that is not collected, reused for every chunk
+				buffer.Reserve(size_);
+				bool stopped = false;
+				previous_.Run([&](auto&& value) {
+					buffer.EmplaceBack(std::forward<decltype(value)>(value));
+					if (buffer.Size() < size_) { return true; }
+					stopped = !sink(Span<const Value>(buffer.begin(), buffer.Size()));
+					while (buffer.Size() > 0) { buffer.PopBack(); }
+					return !stopped;
+				});
+				if (!stopped && buffer.Size() > 0) {	// last, partial chunk
+					stopped = !sink(Span<const Value>(buffer.begin(), buffer.Size()));
+				}
+				return !stopped;
+			}
+
+			size_t SizeHint() const noexcept { return (previous_.SizeHint() + size_ - 1) / size_; }
+
+		private:
+
+			Previous previous_;
+			size_t size_;
+	};
+
+}  // namespace pipeline_detail
+
+template <typename Value, typename Stage>
+class Pipeline {	// Value - type handed to the next stage, Stage - the fused chain producing it
+
+	public:
+
+		explicit Pipeline(Stage stage) : stage_(std::move(stage)) {}
+
+		// --- Lazy stages (no work is done until a terminal operation) ---
+
+		template <typename Function>
+		auto Map(Function function) const {
+			using Result = std::decay_t<std::invoke_result_t<const Function&, const Value&>>;
+			using Next = pipeline_detail::MapStage<Stage, Function>;
+			return Pipeline<Result, Next>(Next(stage_, std::move(function)));
+		}
+
+		template <typename Predicate>
+		auto Filter(Predicate predicate) const {
+			using Next = pipeline_detail::FilterStage<Stage, Predicate>;
+			return Pipeline<Value, Next>(Next(stage_, std::move(predicate)));
+		}
+
+		auto Take(size_t count) const {
+			using Next = pipeline_detail::TakeStage<Stage>;
+			return Pipeline<Value, Next>(Next(stage_, count));
+		}
+
+		template <typename U>
+		auto Zip(Span<const U> other) const {
+			using Next = pipeline_detail::ZipStage<Stage, U>;
+			return Pipeline<std::pair<Value, U>, Next>(Next(stage_, other));
+		}
+
+		template <typename U>
+		auto Zip(const Vector<U>& other) const { return Zip(other.AsSpan()); }
+
+		auto Chunk(size_t size) const {
+			using Next = pipeline_detail::ChunkStage<Stage, Value>;
+			return Pipeline<Span<const Value>, Next>(Next(stage_, size));
+		}
+
+		// --- Terminal operations ---
+
+		template <typename Function>
+		void ForEach(Function function) const {
+			stage_.Run([&](auto&& value) {
+				function(std::forward<decltype(value)>(value));
+				return true;
+			});
+		}
+
+		size_t Count() const {
+			size_t count = 0;
+			stage_.Run([&count](auto&&) { ++count; return true; });
+			return count;
+		}
+
+		size_t SizeHint() const noexcept { return stage_.SizeHint(); }	// Upper bound, exact unless a Filter is in the chain
+
+		Vector<Value> Collect() const {	// Reserves the hint only when it is tight, after a Filter the result grows geometrically
+			return Collect(Stage::TIGHT_HINT ? SizeHint() : 0);
+		}
+
+		Vector<Value> Collect(size_t size_hint) const {	// One Reserve up front, the vector still grows if the hint was too small
+			static_assert(!Stage::BORROWS_BUFFER, "Chunk spans point into a buffer reused for the next chunk - Map them to values before Collect");
+			Vector<Value> result;
+			result.Reserve(size_hint);
+			stage_.Run([&result](auto&& value) {
+				result.EmplaceBack(std::forward<decltype(value)>(value));
+				return true;
+			});
+			return result;
+		}
+
+	private:
+
+		Stage stage_;
+};
+
+template <typename T>
+auto Pipe(Span<const T> span) { return Pipeline<T, pipeline_detail::SpanSource<T>>(pipeline_detail::SpanSource<T>(span)); }
+
+template <typename T>
+auto Pipe(Span<T> span) { return Pipe(Span<const T>(span)); }
+
+template <typename T, typename Allocator>
+auto Pipe(const Vector<T, Allocator>& vector) { return Pipe(vector.AsSpan()); }	// The vector must outlive the pipeline
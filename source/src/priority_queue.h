@@ -0,0 +1,266 @@
+#pragma once
+
+#include "vector.h"
+
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <limits>
+#include <utility>
+
+// d-ary heaps stored in a Vector. With ARITY children per node the tree is log2(ARITY) times
+// shallower than a binary heap, and with 4 children of a small T all siblings share one cache line,
+// so a sift-down touches fewer lines for a few more compares. Sifts move a hole instead of swapping.
+// Like std::priority_queue, Top is the element that is greatest under Compare.
+
+namespace priority_queue_detail {
+
+	struct NoTracking {
+		template <typename Entry>
+		void operator()(const Entry&, size_t) const noexcept {}
+	};
+
+	template <size_t ARITY, typename Entry, typename Less, typename Track>
+	void SiftUp(Entry* heap, size_t hole, Less& less, Track& track) {
+		Entry value = std::move(heap[hole]);
+		while (hole > 0) {
+			size_t parent = (hole - 1) / ARITY;
+			if (!less(heap[parent], value)) { break; }
+			heap[hole] = std::move(heap[parent]);
+			track(heap[hole], hole);
+			hole = parent;
+		}
+		heap[hole] = std::move(value);
+		track(heap[hole], hole);
+	}
+
+	template <size_t ARITY, typename Entry, typename Less, typename Track>
+	void SiftDown(Entry* heap, size_t size, size_t hole, Less& less, Track& track) {
+		Entry value = std::move(heap[hole]);
+		while (true) {
+			size_t first = hole * ARITY + 1;
+			if (first >= size) { break; }
+			size_t last = first + ARITY < size ? first + ARITY : size;
+			size_t best = first;
+			for (size_t child = first + 1; child < last; ++child) {
+				if (less(heap[best], heap[child])) { best = child; }
+			}
+			if (!less(value, heap[best])) { break; }
+			heap[hole] = std::move(heap[best]);
+			track(heap[hole], hole);
+			hole = best;
+		}
+		heap[hole] = std::move(value);
+		track(heap[hole], hole);
+	}
+
+	template <size_t ARITY, typename Entry, typename Less, typename Track>
+	void Heapify(Entry* heap, size_t size, Less& less, Track& track) {	// Floyd's bottom-up build, O(N)
+		if (size < 2) { return; }
+		for (size_t node = (size - 2) / ARITY + 1; node-- > 0;) { SiftDown<ARITY>(heap, size, node, less, track); }
+	}
+
+}  // namespace priority_queue_detail
+
+template <typename T, typename Compare = std::less<>, size_t ARITY = 4>
+class PriorityQueue {
+
+	static_assert(ARITY >= 2, "a heap node needs at least two children");
+
+	public:
+
+		// --- Constructors ---
+
+		PriorityQueue() = default;
+
+		explicit PriorityQueue(Compare compare)
+			: compare_(std::move(compare))
+		{}
+
+		explicit PriorityQueue(Span<const T> range, Compare compare = Compare())	// Bulk build - one heapify instead of N pushes
+			: compare_(std::move(compare))
+		{
+			heap_.Reserve(range.Size());
+			for (const T& value : range) { heap_.PushBack(value); }
+			Heapify();
+		}
+
+		explicit PriorityQueue(Vector<T>&& values, Compare compare = Compare())	// Adopts the buffer
+			: heap_(std::move(values))
+			, compare_(std::move(compare))
+		{
+			Heapify();
+		}
+
+		// --- Capacity ---
+
+		size_t Size()     const noexcept { return heap_.Size(); }
+		bool   Empty()    const noexcept { return heap_.Size() == 0; }
+		size_t Capacity() const noexcept { return heap_.Capacity(); }
+
+		void Reserve(size_t new_capacity) { heap_.Reserve(new_capacity); }
+
+		// --- Heap operations ---
+
+		const T& Top() const noexcept {
+			assert(!Empty());
+			return heap_[0];
+		}
+
+		template <typename Type>
+		void Push(Type&& value) { Emplace(std::forward<Type>(value)); }
+
+		template <typename... Args>
+		void Emplace(Args&&... args) {
+			heap_.EmplaceBack(std::forward<Args>(args)...);
+			priority_queue_detail::NoTracking track;
+			priority_queue_detail::SiftUp<ARITY>(heap_.begin(), heap_.Size() - 1, compare_, track);
+		}
+
+		void Pop() {
+			assert(!Empty());
+			if (heap_.Size() > 1) {
+				heap_[0] = std::move(heap_[heap_.Size() - 1]);
+				heap_.PopBack();
+				priority_queue_detail::NoTracking track;
+				priority_queue_detail::SiftDown<ARITY>(heap_.begin(), heap_.Size(), 0, compare_, track);
+			}
+			else { heap_.PopBack(); }
+		}
+
+		T Extract() {		// Pop that hands the top element over
+			assert(!Empty());
+			T top = std::move(heap_[0]);
+			Pop();
+			return top;
+		}
+
+		Vector<T> Release() && noexcept { return std::move(heap_); }	// The underlying heap-ordered buffer
+
+	private:
+
+		void Heapify() {
+			priority_queue_detail::NoTracking track;
+			priority_queue_detail::Heapify<ARITY>(heap_.begin(), heap_.Size(), compare_, track);
+		}
+
+		Vector<T> heap_;
+		Compare compare_;
+};
+
+template <typename T, typename Compare = std::less<>, size_t ARITY = 4>
+class IndexedPriorityQueue {	// Heap of (id, priority) with an id -> position map, so any queued id can be re-prioritized or erased in O(log N)
+
+	static_assert(ARITY >= 2, "a heap node needs at least two children");
+
+	public:
+
+		static constexpr size_t NPOS = std::numeric_limits<size_t>::max();
+
+		// --- Constructors ---
+
+		IndexedPriorityQueue() = default;
+
+		explicit IndexedPriorityQueue(size_t id_count, Compare compare = Compare())	// ids below id_count need no map growth
+			: compare_(std::move(compare))
+		{
+			GrowPositions(id_count);
+		}
+
+		// --- Capacity ---
+
+		size_t Size()  const noexcept { return heap_.Size(); }
+		bool   Empty() const noexcept { return heap_.Size() == 0; }
+
+		bool Contains(size_t id) const noexcept { return id < positions_.Size() && positions_[id] != NPOS; }
+
+		// --- Heap operations ---
+
+		const T& Top()   const noexcept { assert(!Empty()); return heap_[0].priority; }
+		size_t   TopId() const noexcept { assert(!Empty()); return heap_[0].id; }
+
+		const T& Priority(size_t id) const noexcept {
+			assert(Contains(id));
+			return heap_[positions_[id]].priority;
+		}
+
+		void Push(size_t id, T priority) {
+			assert(!Contains(id));
+			if (id >= positions_.Size()) { GrowPositions(id + 1); }
+			heap_.PushBack(Entry{ std::move(priority), id });
+			SiftUp(heap_.Size() - 1);
+		}
+
+		void Update(size_t id, T priority) {	// Decrease-key and increase-key - sifts whichever way the new priority requires
+			assert(Contains(id));
+			size_t position = positions_[id];
+			bool raised = compare_(heap_[position].priority, priority);
+			heap_[position].priority = std::move(priority);
+			if (raised) { SiftUp(position); }
+			else        { SiftDown(position); }
+		}
+
+		void PushOrUpdate(size_t id, T priority) {
+			if (Contains(id)) { Update(id, std::move(priority)); }
+			else              { Push(id, std::move(priority)); }
+		}
+
+		void Pop() {
+			assert(!Empty());
+			Erase(heap_[0].id);
+		}
+
+		void Erase(size_t id) {
+			assert(Contains(id));
+			size_t position = positions_[id];
+			positions_[id] = NPOS;
+			size_t last = heap_.Size() - 1;
+			if (position != last) {
+				heap_[position] = std::move(heap_[last]);
+				heap_.PopBack();
+				if (position > 0 && compare_(heap_[(position - 1) / ARITY].priority, heap_[position].priority)) { SiftUp(position); }
+				else { SiftDown(position); }
+			}
+			else { heap_.PopBack(); }
+		}
+
+	private:
+
+		struct Entry {
+			T priority;
+			size_t id;
+		};
+
+		struct EntryLess {
+			Compare& compare;
+			bool operator()(const Entry& a, const Entry& b) { return compare(a.priority, b.priority); }
+		};
+
+		struct Track {
+			Vector<size_t>& positions;
+			void operator()(const Entry& entry, size_t position) noexcept { positions[entry.id] = position; }
+		};
+
+		void GrowPositions(size_t id_count) {
+			size_t old_size = positions_.Size();
+			if (id_count <= old_size) { return; }
+			positions_.Reserve(std::max(id_count, old_size * 2));
+			for (size_t id = old_size; id < id_count; ++id) { positions_.PushBack(NPOS); }
+		}
+
+		void SiftUp(size_t position) {
+			EntryLess less{ compare_ };
+			Track track{ positions_ };
+			priority_queue_detail::SiftUp<ARITY>(heap_.begin(), position, less, track);
+		}
+
+		void SiftDown(size_t position) {
+			EntryLess less{ compare_ };
+			Track track{ positions_ };
+			priority_queue_detail::SiftDown<ARITY>(heap_.begin(), heap_.Size(), position, less, track);
+		}
+
+		Vector<Entry> heap_;
+		Vector<size_t> positions_;		// id -> index in heap_, NPOS when not queued
+		Compare compare_;
+};
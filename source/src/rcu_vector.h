@@ -0,0 +1,194 @@
+#pragma once
+
+#include "vector.h"
+#include "cache_line.h"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <stdexcept>
+
+template <typename T>
+class RcuVector {	// Writers publish whole new versions, readers see a consistent snapshot without taking any lock
+
+	struct alignas(CACHE_LINE_SIZE) ReaderSlot {	// One line per reader so readers never write to a shared line
+		std::atomic<uint64_t> epoch{ 0 };		// Epoch the reader entered in, 0 - outside of a read section
+		std::atomic<bool> in_use{ false };
+	};
+
+	struct Retired {
+		Vector<T>* version;
+		uint64_t epoch;			// Readers that entered at this epoch or earlier may still see the version
+	};
+
+	public:
+
+		class Snapshot;
+		class Reader;
+
+		// --- Constructors ---
+
+		explicit RcuVector(Vector<T> initial = Vector<T>(), size_t max_readers = 64)
+			: current_(new Vector<T>(std::move(initial)))
+			, readers_(max_readers)
+		{
+			for (size_t i = 0; i < readers_.Capacity(); ++i) {
+				new (readers_ + i) ReaderSlot();
+			}
+		}
+
+		RcuVector(const RcuVector&) = delete;
+		RcuVector& operator=(const RcuVector&) = delete;
+
+		// --- Destructor ---
+
+		~RcuVector() {	// Every Reader must be gone by now
+			for (size_t i = 0; i < retired_.Size(); ++i) {
+				delete retired_[i].version;
+			}
+			delete current_.load(std::memory_order_relaxed);
+			std::destroy_n(readers_.GetAddress(), readers_.Capacity());
+		}
+
+		// --- Reader functions ---
+
+		Reader RegisterReader() {	// Each reading thread holds its own Reader
+			for (size_t i = 0; i < readers_.Capacity(); ++i) {
+				bool expected = false;
+				if (readers_[i].in_use.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+					return Reader(*this, readers_[i]);
+				}
+			}
+			throw std::length_error("RcuVector: too many readers");
+		}
+
+		// --- Writer functions (serialized by a mutex, readers are never blocked) ---
+
+		void Publish(Vector<T> version) {
+			std::lock_guard lock(writer_mutex_);
+			PublishLocked(new Vector<T>(std::move(version)));
+		}
+
+		template <typename Mutation>
+		void Update(Mutation mutation) {	// Copy the current version, mutate the copy and publish it
+			std::lock_guard lock(writer_mutex_);
+			Vector<T>* version = new Vector<T>(*current_.load(std::memory_order_relaxed));
+			try {
+				mutation(*version);
+			}
+			catch (...) {
+				delete version;
+				throw;
+			}
+			PublishLocked(version);
+		}
+
+		size_t Reclaim() {	// Free retired versions no reader can see any more, returns how many are still pending
+			std::lock_guard lock(writer_mutex_);
+			ReclaimLocked();
+			return retired_.Size();
+		}
+
+	private:
+
+		void PublishLocked(Vector<T>* version) {
+			if (retired_.Size() == retired_.Capacity()) {	// the only allocation, done before anything becomes visible
+				try {
+					retired_.Reserve(retired_.Size() * 2 + 1);
+				}
+				catch (...) {
+					delete version;
+					throw;
+				}
+			}
+			Vector<T>* old = current_.exchange(version, std::memory_order_seq_cst);
+			uint64_t epoch = global_epoch_.fetch_add(1, std::memory_order_seq_cst);	// readers entering later get a later epoch and the new version
+			retired_.PushBack(Retired{ old, epoch });
+			ReclaimLocked();
+		}
+
+		void ReclaimLocked() {
+			uint64_t oldest = UINT64_MAX;
+			for (size_t i = 0; i < readers_.Capacity(); ++i) {
+				uint64_t epoch = readers_[i].epoch.load(std::memory_order_seq_cst);
+				if (epoch != 0 && epoch < oldest) { oldest = epoch; }
+			}
+			size_t kept = 0;
+			for (size_t i = 0; i < retired_.Size(); ++i) {
+				if (retired_[i].epoch < oldest) {
+					delete retired_[i].version;
+				}
+				else {
+					retired_[kept++] = retired_[i];
+				}
+			}
+			while (retired_.Size() > kept) { retired_.PopBack(); }
+		}
+
+		std::atomic<Vector<T>*> current_;			// Published version
+		std::atomic<uint64_t> global_epoch_{ 1 };	// Starts at 1, 0 marks a quiescent reader
+		RawMemory<ReaderSlot> readers_;				// Allocated raw memory for reader slots
+		std::mutex writer_mutex_;
+		Vector<Retired> retired_;					// Versions waiting for readers to leave
+};
+
+template <typename T>
+class RcuVector<T>::Snapshot {	// Keeps one version alive while it exists
+
+	public:
+
+		Snapshot(const Snapshot&) = delete;
+		Snapshot& operator=(const Snapshot&) = delete;
+
+		~Snapshot() { slot_.epoch.store(0, std::memory_order_release); }
+
+		const Vector<T>& operator*()  const noexcept { return *version_; }
+		const Vector<T>* operator->() const noexcept { return version_; }
+
+	private:
+
+		friend class Reader;
+
+		Snapshot(const RcuVector& owner, ReaderSlot& slot) noexcept
+			: slot_(slot)
+		{
+			slot_.epoch.store(owner.global_epoch_.load(std::memory_order_seq_cst), std::memory_order_seq_cst);	// announce before reading the pointer
+			version_ = owner.current_.load(std::memory_order_seq_cst);
+		}
+
+		ReaderSlot& slot_;
+		const Vector<T>* version_ = nullptr;
+};
+
+template <typename T>
+class RcuVector<T>::Reader {	// A registered reader, one Snapshot at a time
+
+	public:
+
+		Reader(Reader&& other) noexcept
+			: owner_(other.owner_)
+			, slot_(std::exchange(other.slot_, nullptr))
+		{}
+
+		Reader(const Reader&) = delete;
+		Reader& operator=(const Reader&) = delete;
+		Reader& operator=(Reader&&) = delete;
+
+		~Reader() {
+			if (slot_ != nullptr) { slot_->in_use.store(false, std::memory_order_release); }
+		}
+
+		Snapshot Read() const noexcept { return Snapshot(*owner_, *slot_); }	// Wait-free
+
+	private:
+
+		friend class RcuVector;
+
+		Reader(RcuVector& owner, ReaderSlot& slot) noexcept
+			: owner_(&owner)
+			, slot_(&slot)
+		{}
+
+		RcuVector* owner_;
+		ReaderSlot* slot_;
+};
@@ -0,0 +1,175 @@
+#pragma once
+
+#include "vector.h"
+
+#include <algorithm>
+#include <type_traits>
+
+enum class RingOverflow {
+	REJECT,				// PushBack into a full buffer fails
+	OVERWRITE_OLDEST	// PushBack into a full buffer drops the front element
+};
+
+template <typename T>
+class RingBuffer {
+
+	public:
+
+		template <typename Pointer>
+		struct TwoSpans {	// A wrapped region of the ring: first part up to the end of memory, second part from its beginning
+			Pointer first = nullptr;
+			size_t first_size = 0;
+			Pointer second = nullptr;
+			size_t second_size = 0;
+
+			size_t Size() const noexcept { return first_size + second_size; }
+		};
+
+		// --- Constructors ---
+
+		explicit RingBuffer(size_t min_capacity, RingOverflow overflow = RingOverflow::REJECT)	// Capacity is rounded up to a power of two
+			: data_(RoundUpToPowerOfTwo(min_capacity))
+			, mask_(data_.Capacity() - 1)
+			, overflow_(overflow)
+		{}
+
+		RingBuffer(const RingBuffer& other)
+			: data_(other.Capacity())
+			, mask_(other.mask_)
+			, overflow_(other.overflow_)
+		{
+			try {
+				for (; tail_ < other.Size(); ++tail_) {	// copy in logical order, tail_ counts constructed elements
+					new (data_ + tail_) T(other[tail_]);
+				}
+			}
+			catch (...) {
+				std::destroy_n(data_.GetAddress(), tail_);	// in case of throwing exception, destroy the copied part
+				throw;
+			}
+		}
+
+		RingBuffer(RingBuffer&& other) noexcept { Swap(other); }
+
+		// --- Destructor ---
+
+		~RingBuffer() { Clear(); }
+
+		// --- Operators overloads ---
+
+		const T& operator[](size_t index) const noexcept { return const_cast<RingBuffer&>(*this)[index]; }	// Constancy trick to avoid duplication of assert
+			  T& operator[](size_t index)       noexcept { assert(index < Size()); return data_[(head_ + index) & mask_]; }
+
+		RingBuffer& operator=(const RingBuffer& rhs) {
+			if (this != &rhs) {				// checking for self-assignment
+				RingBuffer rhs_copy(rhs);	// copy-and-swap
+				Swap(rhs_copy);
+			}
+			return *this;
+		}
+
+		RingBuffer& operator=(RingBuffer&& rhs) noexcept {
+			if (this != &rhs) { Swap(rhs); }	// checking for self-assignment, swap
+			return *this;
+		}
+
+		// --- Queue functions ---
+
+		size_t Size()     const noexcept { return tail_ - head_; }	// Counters only grow, unsigned wrap-around keeps the difference right
+		size_t Capacity() const noexcept { return data_.Capacity(); }
+		bool   Empty()    const noexcept { return head_ == tail_; }
+		bool   Full()     const noexcept { return Size() == Capacity(); }
+
+		void Swap(RingBuffer& other) noexcept {
+			data_.Swap(other.data_);
+			std::swap(mask_, other.mask_);
+			std::swap(head_, other.head_);
+			std::swap(tail_, other.tail_);
+			std::swap(overflow_, other.overflow_);
+		}
+
+		template <typename Type>
+		bool PushBack(Type&& value) { return EmplaceBack(std::forward<Type>(value)); }
+
+		template <typename... Args>
+		bool EmplaceBack(Args&&... args) {	// false if the buffer is full and overflow is REJECT
+			if (Full()) {
+				if (overflow_ == RingOverflow::REJECT || Capacity() == 0) { return false; }
+				T value(std::forward<Args>(args)...);	// args may refer to the element about to be dropped
+				PopFront();
+				new (data_ + (tail_ & mask_)) T(std::move(value));
+			}
+			else {
+				new (data_ + (tail_ & mask_)) T(std::forward<Args>(args)...);
+			}
+			++tail_;
+			return true;
+		}
+
+		void PopFront() {
+			if (!Empty()) {
+				std::destroy_at(data_ + (head_ & mask_));
+				++head_;
+			}
+		}
+
+		const T& Front() const noexcept { return const_cast<RingBuffer&>(*this).Front(); }	// Constancy trick to avoid duplication of assert
+		const T& Back()  const noexcept { return const_cast<RingBuffer&>(*this).Back() ; }
+			  T& Front()       noexcept { assert(!Empty()); return data_[head_ & mask_]; }
+			  T& Back()        noexcept { assert(!Empty()); return data_[(tail_ - 1) & mask_]; }
+
+		void Clear() noexcept {
+			Consume(Size());
+		}
+
+		// --- Bulk access for zero-copy I/O ---
+
+		TwoSpans<const T*> ReadableSpans() const noexcept {	// Live elements in logical order
+			return Split<const T*>(head_, Size());
+		}
+
+		void Consume(size_t count) noexcept {	// Drop count elements from the front after reading them through ReadableSpans
+			assert(count <= Size());
+			TwoSpans<const T*> spans = Split<const T*>(head_, count);
+			std::destroy_n(const_cast<T*>(spans.first), spans.first_size);
+			std::destroy_n(const_cast<T*>(spans.second), spans.second_size);
+			head_ += count;
+		}
+
+		TwoSpans<T*> WritableSpans() noexcept {	// Free slots after the back, only for trivially copyable elements
+			static_assert(std::is_trivially_copyable_v<T>, "raw writes are only valid for trivially copyable types");
+			return Split<T*>(tail_, Capacity() - Size());
+		}
+
+		void Commit(size_t count) noexcept {	// Publish count elements written through WritableSpans
+			static_assert(std::is_trivially_copyable_v<T>, "raw writes are only valid for trivially copyable types");
+			assert(count <= Capacity() - Size());
+			tail_ += count;
+		}
+
+	private:
+
+		static size_t RoundUpToPowerOfTwo(size_t n) noexcept {
+			size_t result = 1;
+			while (result < n) { result <<= 1; }
+			return result;
+		}
+
+		template <typename Pointer>
+		TwoSpans<Pointer> Split(size_t position, size_t count) const noexcept {
+			TwoSpans<Pointer> result;
+			if (count == 0) { return result; }
+			size_t start = position & mask_;
+			result.first = const_cast<Pointer>(data_ + start);
+			result.first_size = std::min(count, Capacity() - start);
+			result.second = const_cast<Pointer>(data_.GetAddress());
+			result.second_size = count - result.first_size;
+			return result;
+		}
+
+		RawMemory<T> data_;		// Allocated raw memory, capacity is a power of two
+		size_t mask_ = 0;		// Capacity - 1
+		size_t head_ = 0;		// Number of elements ever popped
+		size_t tail_ = 0;		// Number of elements ever pushed
+		RingOverflow overflow_ = RingOverflow::REJECT;
+};
@@ -0,0 +1,181 @@
+#pragma once
+
+#include "vector.h"
+#include "simd.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+
+// Prefix sums for Vector<int32_t>, Vector<float> and Vector<double>.
+// Each register is scanned in log2(width) shift-and-add steps and a running carry is kept in a
+// register. Large inputs take a reduce-then-scan pass over blocks on the thread pool: block sums
+// are computed in parallel, scanned serially, then every block is scanned with its own carry-in.
+// Floating point sums are reassociated, so results may differ from a serial loop in the last bits.
+
+namespace scan_detail {
+
+	inline constexpr size_t PARALLEL_MIN_SIZE = size_t{ 1 } << 18;	// Below this one thread wins, the pool costs more than it saves
+	inline constexpr size_t MIN_BLOCK = size_t{ 1 } << 15;
+	inline constexpr size_t MAX_BLOCKS = 256;
+
+	template <typename T>
+	inline constexpr bool IS_SCAN_ELEMENT = std::is_same_v<T, int32_t> || std::is_same_v<T, float> || std::is_same_v<T, double>;
+
+	template <bool INCLUSIVE, typename T>
+	T ScalarScan(const T* input, T* output, size_t count, T carry) noexcept {	// Returns the sum including every element, output may alias input
+		for (size_t i = 0; i < count; ++i) {
+			T value = input[i];
+			if constexpr (INCLUSIVE) { carry += value; output[i] = carry; }
+			else                     { output[i] = carry; carry += value; }
+		}
+		return carry;
+	}
+
+#if VECTOR_SIMD_X86
+
+	template <typename T> struct Avx2Scan;
+
+	template <> struct Avx2Scan<int32_t> {
+		using Register = __m256i;
+		static constexpr size_t WIDTH = 8;
+		SIMD_INLINE_AVX2 static Register Load(const int32_t* p) noexcept { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+		SIMD_INLINE_AVX2 static void Store(int32_t* p, Register r) noexcept { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), r); }
+		SIMD_INLINE_AVX2 static Register Broadcast(int32_t value) noexcept { return _mm256_set1_epi32(value); }
+		SIMD_INLINE_AVX2 static Register Add(Register a, Register b) noexcept { return _mm256_add_epi32(a, b); }
+		SIMD_INLINE_AVX2 static Register Prefix(Register x) noexcept {
+			x = _mm256_add_epi32(x, _mm256_slli_si256(x, 4));		// within each 128-bit lane
+			x = _mm256_add_epi32(x, _mm256_slli_si256(x, 8));
+			Register low = _mm256_permute2x128_si256(x, x, 0x08);	// [0, low lane]
+			return _mm256_add_epi32(x, _mm256_shuffle_epi32(low, 0xFF));	// add the low lane total to the high lane
+		}
+		SIMD_INLINE_AVX2 static Register ShiftOne(Register x) noexcept {	// [0, x0, ..., x6]
+			Register shifted = _mm256_permutevar8x32_epi32(x, _mm256_setr_epi32(0, 0, 1, 2, 3, 4, 5, 6));
+			return _mm256_blend_epi32(shifted, _mm256_setzero_si256(), 0x01);
+		}
+		SIMD_INLINE_AVX2 static Register BroadcastLast(Register x) noexcept { return _mm256_permutevar8x32_epi32(x, _mm256_set1_epi32(7)); }
+		SIMD_INLINE_AVX2 static int32_t First(Register x) noexcept { return _mm256_cvtsi256_si32(x); }
+	};
+
+	template <> struct Avx2Scan<float> {
+		using Register = __m256;
+		static constexpr size_t WIDTH = 8;
+		SIMD_INLINE_AVX2 static Register Load(const float* p) noexcept { return _mm256_loadu_ps(p); }
+		SIMD_INLINE_AVX2 static void Store(float* p, Register r) noexcept { _mm256_storeu_ps(p, r); }
+		SIMD_INLINE_AVX2 static Register Broadcast(float value) noexcept { return _mm256_set1_ps(value); }
+		SIMD_INLINE_AVX2 static Register Add(Register a, Register b) noexcept { return _mm256_add_ps(a, b); }
+		SIMD_INLINE_AVX2 static Register Prefix(Register x) noexcept {
+			x = _mm256_add_ps(x, _mm256_castsi256_ps(_mm256_slli_si256(_mm256_castps_si256(x), 4)));
+			x = _mm256_add_ps(x, _mm256_castsi256_ps(_mm256_slli_si256(_mm256_castps_si256(x), 8)));
+			Register low = _mm256_permute2f128_ps(x, x, 0x08);
+			return _mm256_add_ps(x, _mm256_shuffle_ps(low, low, 0xFF));
+		}
+		SIMD_INLINE_AVX2 static Register ShiftOne(Register x) noexcept {
+			Register shifted = _mm256_permutevar8x32_ps(x, _mm256_setr_epi32(0, 0, 1, 2, 3, 4, 5, 6));
+			return _mm256_blend_ps(shifted, _mm256_setzero_ps(), 0x01);
+		}
+		SIMD_INLINE_AVX2 static Register BroadcastLast(Register x) noexcept { return _mm256_permutevar8x32_ps(x, _mm256_set1_epi32(7)); }
+		SIMD_INLINE_AVX2 static float First(Register x) noexcept { return _mm256_cvtss_f32(x); }
+	};
+
+	template <> struct Avx2Scan<double> {
+		using Register = __m256d;
+		static constexpr size_t WIDTH = 4;
+		SIMD_INLINE_AVX2 static Register Load(const double* p) noexcept { return _mm256_loadu_pd(p); }
+		SIMD_INLINE_AVX2 static void Store(double* p, Register r) noexcept { _mm256_storeu_pd(p, r); }
+		SIMD_INLINE_AVX2 static Register Broadcast(double value) noexcept { return _mm256_set1_pd(value); }
+		SIMD_INLINE_AVX2 static Register Add(Register a, Register b) noexcept { return _mm256_add_pd(a, b); }
+		SIMD_INLINE_AVX2 static Register Prefix(Register x) noexcept {
+			x = _mm256_add_pd(x, _mm256_castsi256_pd(_mm256_slli_si256(_mm256_castpd_si256(x), 8)));
+			Register low = _mm256_permute2f128_pd(x, x, 0x08);
+			return _mm256_add_pd(x, _mm256_permute_pd(low, 0x0F));	// [x1, x1] of the low lane
+		}
+		SIMD_INLINE_AVX2 static Register ShiftOne(Register x) noexcept {
+			Register shifted = _mm256_permute4x64_pd(x, 0x90);		// [x0, x0, x1, x2]
+			return _mm256_blend_pd(shifted, _mm256_setzero_pd(), 0x01);
+		}
+		SIMD_INLINE_AVX2 static Register BroadcastLast(Register x) noexcept { return _mm256_permute4x64_pd(x, 0xFF); }
+		SIMD_INLINE_AVX2 static double First(Register x) noexcept { return _mm256_cvtsd_f64(x); }
+	};
+
+	template <bool INCLUSIVE, typename T>
+	SIMD_TARGET_AVX2 T Avx2ScanKernel(const T* input, T* output, size_t count, T carry) noexcept {
+		using Isa = Avx2Scan<T>;
+		typename Isa::Register running = Isa::Broadcast(carry);
+		size_t i = 0;
+		for (; i + Isa::WIDTH <= count; i += Isa::WIDTH) {
+			typename Isa::Register prefix = Isa::Prefix(Isa::Load(input + i));
+			if constexpr (INCLUSIVE) { Isa::Store(output + i, Isa::Add(prefix, running)); }
+			else                     { Isa::Store(output + i, Isa::Add(Isa::ShiftOne(prefix), running)); }
+			running = Isa::Add(running, Isa::BroadcastLast(prefix));
+		}
+		return ScalarScan<INCLUSIVE>(input + i, output + i, count - i, Isa::First(running));
+	}
+
+#endif
+
+	template <bool INCLUSIVE, typename T>
+	T ScanBlock(const T* input, T* output, size_t count, T carry) noexcept {
+#if VECTOR_SIMD_X86
+		if (ActiveSimdLevel() >= SimdLevel::AVX2) { return Avx2ScanKernel<INCLUSIVE>(input, output, count, carry); }	// AVX-512 uses the same kernel
+#endif
+		return ScalarScan<INCLUSIVE>(input, output, count, carry);
+	}
+
+	template <bool INCLUSIVE, typename T>
+	void Scan(Span<const T> input, Span<T> output, T init, ThreadPool& pool) {
+		static_assert(IS_SCAN_ELEMENT<T>, "scans are provided for int32_t, float and double");
+		assert(input.Size() == output.Size());
+		size_t size = input.Size();
+		if (size < PARALLEL_MIN_SIZE) {
+			ScanBlock<INCLUSIVE>(input.GetAddress(), output.GetAddress(), size, init);
+			return;
+		}
+
+		size_t block = std::max(MIN_BLOCK, (size + MAX_BLOCKS - 1) / MAX_BLOCKS);	// depends on the size only - stable float results
+		size_t blocks = (size + block - 1) / block;
+		T offsets[MAX_BLOCKS + 1];
+
+		ParallelFor(blocks, [&](size_t first, size_t last) {		// pass 1: block sums, read only
+			for (size_t b = first; b < last; ++b) {
+				const T* data = input.GetAddress() + b * block;
+				size_t count = std::min(block, size - b * block);
+				T sum = T{};
+				for (size_t i = 0; i < count; ++i) { sum += data[i]; }
+				offsets[b + 1] = sum;
+			}
+		}, 1, pool);
+
+		offsets[0] = init;
+		ScalarScan<true>(offsets + 1, offsets + 1, blocks, init);	// carry-in of every block
+
+		ParallelFor(blocks, [&](size_t first, size_t last) {		// pass 2: scan each block from its carry-in
+			for (size_t b = first; b < last; ++b) {
+				size_t begin = b * block;
+				ScanBlock<INCLUSIVE>(input.GetAddress() + begin, output.GetAddress() + begin, std::min(block, size - begin), offsets[b]);
+			}
+		}, 1, pool);
+	}
+
+}  // namespace scan_detail
+
+template <typename T>
+void InclusiveScan(Span<const T> input, Span<T> output, ThreadPool& pool = ThreadPool::Shared()) {	// output[i] = input[0] + ... + input[i], output may be input
+	scan_detail::Scan<true>(input, output, T{}, pool);
+}
+
+template <typename T>
+void ExclusiveScan(Span<const T> input, Span<T> output, T init = T{}, ThreadPool& pool = ThreadPool::Shared()) {	// output[i] = init + input[0] + ... + input[i - 1]
+	scan_detail::Scan<false>(input, output, init, pool);
+}
+
+template <typename T, typename Allocator>
+void InclusiveScan(Vector<T, Allocator>& vector, ThreadPool& pool = ThreadPool::Shared()) {	// In place
+	InclusiveScan(Span<const T>(vector.AsSpan()), vector.AsSpan(), pool);
+}
+
+template <typename T, typename Allocator>
+void ExclusiveScan(Vector<T, Allocator>& vector, T init = T{}, ThreadPool& pool = ThreadPool::Shared()) {	// In place, e.g. sizes into CSR offsets
+	ExclusiveScan(Span<const T>(vector.AsSpan()), vector.AsSpan(), init, pool);
+}
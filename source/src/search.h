@@ -0,0 +1,391 @@
+#pragma once
+
+#include "vector.h"
+#include "simd.h"
+
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+// Linear search primitives over contiguous storage. Vector<int32_t>, Vector<uint64_t> and
+// Vector<float> compare a whole register per step (SSE4.2, AVX2 or AVX-512, picked at run time),
+// other element types take the scalar loop. Float comparisons follow operator== (NaN never matches,
+// -0.0f == 0.0f); MinMax and ArgMin of ranges holding NaN are unspecified.
+
+inline constexpr size_t SEARCH_NPOS = std::numeric_limits<size_t>::max();	// Find result when nothing matches
+
+namespace search_detail {
+
+	template <typename T>
+	inline constexpr bool IS_SIMD_ELEMENT = std::is_same_v<T, int32_t> || std::is_same_v<T, uint64_t> || std::is_same_v<T, float>;
+
+	template <typename T>
+	struct NonDeduced { using Type = T; };	// Find(v, 5) for a Vector<uint64_t> - the value converts instead of failing deduction
+
+	template <typename T>
+	size_t ScalarFind(const T* data, size_t count, const T& value) noexcept {
+		for (size_t i = 0; i < count; ++i) {
+			if (data[i] == value) { return i; }
+		}
+		return SEARCH_NPOS;
+	}
+
+	template <typename T>
+	size_t ScalarCount(const T* data, size_t count, const T& value) noexcept {
+		size_t matches = 0;
+		for (size_t i = 0; i < count; ++i) { matches += data[i] == value; }
+		return matches;
+	}
+
+	template <typename T>
+	void ScalarMinMax(const T* data, size_t count, T& min, T& max) noexcept {	// Folds data into min and max
+		for (size_t i = 0; i < count; ++i) {
+			if (data[i] < min) { min = data[i]; }
+			if (max < data[i]) { max = data[i]; }
+		}
+	}
+
+#if VECTOR_SIMD_X86
+
+	// --- Per-ISA operations: EqualMask has one bit per element, lowest bit - lowest index ---
+
+	template <typename T> struct Sse42;
+
+	template <> struct Sse42<int32_t> {
+		using Register = __m128i;
+		static constexpr size_t WIDTH = 4;
+		SIMD_INLINE_SSE42 static Register Load(const int32_t* p) noexcept { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+		SIMD_INLINE_SSE42 static void Store(int32_t* p, Register r) noexcept { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), r); }
+		SIMD_INLINE_SSE42 static Register Broadcast(int32_t value) noexcept { return _mm_set1_epi32(value); }
+		SIMD_INLINE_SSE42 static uint32_t EqualMask(Register a, Register b) noexcept { return _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(a, b))); }
+		SIMD_INLINE_SSE42 static Register Min(Register a, Register b) noexcept { return _mm_min_epi32(a, b); }
+		SIMD_INLINE_SSE42 static Register Max(Register a, Register b) noexcept { return _mm_max_epi32(a, b); }
+	};
+
+	template <> struct Sse42<uint64_t> {
+		using Register = __m128i;
+		static constexpr size_t WIDTH = 2;
+		SIMD_INLINE_SSE42 static Register Load(const uint64_t* p) noexcept { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+		SIMD_INLINE_SSE42 static void Store(uint64_t* p, Register r) noexcept { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), r); }
+		SIMD_INLINE_SSE42 static Register Broadcast(uint64_t value) noexcept { return _mm_set1_epi64x(static_cast<long long>(value)); }
+		SIMD_INLINE_SSE42 static uint32_t EqualMask(Register a, Register b) noexcept { return _mm_movemask_pd(_mm_castsi128_pd(_mm_cmpeq_epi64(a, b))); }
+		SIMD_INLINE_SSE42 static Register Greater(Register a, Register b) noexcept {	// unsigned, through the signed compare with flipped sign bits
+			Register bias = _mm_set1_epi64x(std::numeric_limits<long long>::min());
+			return _mm_cmpgt_epi64(_mm_xor_si128(a, bias), _mm_xor_si128(b, bias));
+		}
+		SIMD_INLINE_SSE42 static Register Min(Register a, Register b) noexcept { return _mm_blendv_epi8(a, b, Greater(a, b)); }
+		SIMD_INLINE_SSE42 static Register Max(Register a, Register b) noexcept { return _mm_blendv_epi8(b, a, Greater(a, b)); }
+	};
+
+	template <> struct Sse42<float> {
+		using Register = __m128;
+		static constexpr size_t WIDTH = 4;
+		SIMD_INLINE_SSE42 static Register Load(const float* p) noexcept { return _mm_loadu_ps(p); }
+		SIMD_INLINE_SSE42 static void Store(float* p, Register r) noexcept { _mm_storeu_ps(p, r); }
+		SIMD_INLINE_SSE42 static Register Broadcast(float value) noexcept { return _mm_set1_ps(value); }
+		SIMD_INLINE_SSE42 static uint32_t EqualMask(Register a, Register b) noexcept { return _mm_movemask_ps(_mm_cmpeq_ps(a, b)); }
+		SIMD_INLINE_SSE42 static Register Min(Register a, Register b) noexcept { return _mm_min_ps(a, b); }
+		SIMD_INLINE_SSE42 static Register Max(Register a, Register b) noexcept { return _mm_max_ps(a, b); }
+	};
+
+	template <typename T> struct Avx2;
+
+	template <> struct Avx2<int32_t> {
+		using Register = __m256i;
+		static constexpr size_t WIDTH = 8;
+		SIMD_INLINE_AVX2 static Register Load(const int32_t* p) noexcept { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+		SIMD_INLINE_AVX2 static void Store(int32_t* p, Register r) noexcept { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), r); }
+		SIMD_INLINE_AVX2 static Register Broadcast(int32_t value) noexcept { return _mm256_set1_epi32(value); }
+		SIMD_INLINE_AVX2 static uint32_t EqualMask(Register a, Register b) noexcept { return _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(a, b))); }
+		SIMD_INLINE_AVX2 static Register Min(Register a, Register b) noexcept { return _mm256_min_epi32(a, b); }
+		SIMD_INLINE_AVX2 static Register Max(Register a, Register b) noexcept { return _mm256_max_epi32(a, b); }
+	};
+
+	template <> struct Avx2<uint64_t> {
+		using Register = __m256i;
+		static constexpr size_t WIDTH = 4;
+		SIMD_INLINE_AVX2 static Register Load(const uint64_t* p) noexcept { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+		SIMD_INLINE_AVX2 static void Store(uint64_t* p, Register r) noexcept { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), r); }
+		SIMD_INLINE_AVX2 static Register Broadcast(uint64_t value) noexcept { return _mm256_set1_epi64x(static_cast<long long>(value)); }
+		SIMD_INLINE_AVX2 static uint32_t EqualMask(Register a, Register b) noexcept { return _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(a, b))); }
+		SIMD_INLINE_AVX2 static Register Greater(Register a, Register b) noexcept {
+			Register bias = _mm256_set1_epi64x(std::numeric_limits<long long>::min());
+			return _mm256_cmpgt_epi64(_mm256_xor_si256(a, bias), _mm256_xor_si256(b, bias));
+		}
+		SIMD_INLINE_AVX2 static Register Min(Register a, Register b) noexcept { return _mm256_blendv_epi8(a, b, Greater(a, b)); }
+		SIMD_INLINE_AVX2 static Register Max(Register a, Register b) noexcept { return _mm256_blendv_epi8(b, a, Greater(a, b)); }
+	};
+
+	template <> struct Avx2<float> {
+		using Register = __m256;
+		static constexpr size_t WIDTH = 8;
+		SIMD_INLINE_AVX2 static Register Load(const float* p) noexcept { return _mm256_loadu_ps(p); }
+		SIMD_INLINE_AVX2 static void Store(float* p, Register r) noexcept { _mm256_storeu_ps(p, r); }
+		SIMD_INLINE_AVX2 static Register Broadcast(float value) noexcept { return _mm256_set1_ps(value); }
+		SIMD_INLINE_AVX2 static uint32_t EqualMask(Register a, Register b) noexcept { return _mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_EQ_OQ)); }
+		SIMD_INLINE_AVX2 static Register Min(Register a, Register b) noexcept { return _mm256_min_ps(a, b); }
+		SIMD_INLINE_AVX2 static Register Max(Register a, Register b) noexcept { return _mm256_max_ps(a, b); }
+	};
+
+	template <typename T> struct Avx512;	// Min/Max use the full-mask forms, the unmasked ones trip -Wmaybe-uninitialized in GCC 12 headers
+
+	template <> struct Avx512<int32_t> {
+		using Register = __m512i;
+		static constexpr size_t WIDTH = 16;
+		SIMD_INLINE_AVX512 static Register Load(const int32_t* p) noexcept { return _mm512_loadu_si512(p); }
+		SIMD_INLINE_AVX512 static void Store(int32_t* p, Register r) noexcept { _mm512_storeu_si512(p, r); }
+		SIMD_INLINE_AVX512 static Register Broadcast(int32_t value) noexcept { return _mm512_set1_epi32(value); }
+		SIMD_INLINE_AVX512 static uint32_t EqualMask(Register a, Register b) noexcept { return _mm512_cmpeq_epi32_mask(a, b); }
+		SIMD_INLINE_AVX512 static Register Min(Register a, Register b) noexcept { return _mm512_mask_min_epi32(a, 0xFFFF, a, b); }
+		SIMD_INLINE_AVX512 static Register Max(Register a, Register b) noexcept { return _mm512_mask_max_epi32(a, 0xFFFF, a, b); }
+	};
+
+	template <> struct Avx512<uint64_t> {
+		using Register = __m512i;
+		static constexpr size_t WIDTH = 8;
+		SIMD_INLINE_AVX512 static Register Load(const uint64_t* p) noexcept { return _mm512_loadu_si512(p); }
+		SIMD_INLINE_AVX512 static void Store(uint64_t* p, Register r) noexcept { _mm512_storeu_si512(p, r); }
+		SIMD_INLINE_AVX512 static Register Broadcast(uint64_t value) noexcept { return _mm512_set1_epi64(static_cast<long long>(value)); }
+		SIMD_INLINE_AVX512 static uint32_t EqualMask(Register a, Register b) noexcept { return _mm512_cmpeq_epi64_mask(a, b); }
+		SIMD_INLINE_AVX512 static Register Min(Register a, Register b) noexcept { return _mm512_mask_min_epu64(a, 0xFF, a, b); }
+		SIMD_INLINE_AVX512 static Register Max(Register a, Register b) noexcept { return _mm512_mask_max_epu64(a, 0xFF, a, b); }
+	};
+
+	template <> struct Avx512<float> {
+		using Register = __m512;
+		static constexpr size_t WIDTH = 16;
+		SIMD_INLINE_AVX512 static Register Load(const float* p) noexcept { return _mm512_loadu_ps(p); }
+		SIMD_INLINE_AVX512 static void Store(float* p, Register r) noexcept { _mm512_storeu_ps(p, r); }
+		SIMD_INLINE_AVX512 static Register Broadcast(float value) noexcept { return _mm512_set1_ps(value); }
+		SIMD_INLINE_AVX512 static uint32_t EqualMask(Register a, Register b) noexcept { return _mm512_cmp_ps_mask(a, b, _CMP_EQ_OQ); }
+		SIMD_INLINE_AVX512 static Register Min(Register a, Register b) noexcept { return _mm512_mask_min_ps(a, 0xFFFF, a, b); }
+		SIMD_INLINE_AVX512 static Register Max(Register a, Register b) noexcept { return _mm512_mask_max_ps(a, 0xFFFF, a, b); }
+	};
+
+	// --- Kernels, one set per ISA since the target attribute cannot be a template parameter ---
+
+	template <typename T>
+	SIMD_TARGET_SSE42 size_t Sse42Find(const T* data, size_t count, T value) noexcept {
+		using Isa = Sse42<T>;
+		typename Isa::Register needle = Isa::Broadcast(value);
+		size_t i = 0;
+		for (; i + Isa::WIDTH <= count; i += Isa::WIDTH) {
+			if (uint32_t mask = Isa::EqualMask(Isa::Load(data + i), needle)) { return i + __builtin_ctz(mask); }
+		}
+		size_t tail = ScalarFind(data + i, count - i, value);
+		return tail == SEARCH_NPOS ? SEARCH_NPOS : i + tail;
+	}
+
+	template <typename T>
+	SIMD_TARGET_SSE42 size_t Sse42Count(const T* data, size_t count, T value) noexcept {
+		using Isa = Sse42<T>;
+		typename Isa::Register needle = Isa::Broadcast(value);
+		size_t matches = 0;
+		size_t i = 0;
+		for (; i + Isa::WIDTH <= count; i += Isa::WIDTH) { matches += __builtin_popcount(Isa::EqualMask(Isa::Load(data + i), needle)); }
+		return matches + ScalarCount(data + i, count - i, value);
+	}
+
+	template <typename T>
+	SIMD_TARGET_SSE42 void Sse42MinMax(const T* data, size_t count, T& min, T& max) noexcept {	// count >= WIDTH
+		using Isa = Sse42<T>;
+		typename Isa::Register low = Isa::Load(data);
+		typename Isa::Register high = low;
+		size_t i = Isa::WIDTH;
+		for (; i + Isa::WIDTH <= count; i += Isa::WIDTH) {
+			typename Isa::Register values = Isa::Load(data + i);
+			low = Isa::Min(low, values);
+			high = Isa::Max(high, values);
+		}
+		T lows[Isa::WIDTH];
+		T highs[Isa::WIDTH];
+		Isa::Store(lows, low);
+		Isa::Store(highs, high);
+		min = lows[0];
+		max = highs[0];
+		ScalarMinMax(lows, Isa::WIDTH, min, max);
+		ScalarMinMax(highs, Isa::WIDTH, min, max);
+		ScalarMinMax(data + i, count - i, min, max);
+	}
+
+	template <typename T>
+	SIMD_TARGET_AVX2 size_t Avx2Find(const T* data, size_t count, T value) noexcept {
+		using Isa = Avx2<T>;
+		typename Isa::Register needle = Isa::Broadcast(value);
+		size_t i = 0;
+		for (; i + Isa::WIDTH <= count; i += Isa::WIDTH) {
+			if (uint32_t mask = Isa::EqualMask(Isa::Load(data + i), needle)) { return i + __builtin_ctz(mask); }
+		}
+		size_t tail = ScalarFind(data + i, count - i, value);
+		return tail == SEARCH_NPOS ? SEARCH_NPOS : i + tail;
+	}
+
+	template <typename T>
+	SIMD_TARGET_AVX2 size_t Avx2Count(const T* data, size_t count, T value) noexcept {
+		using Isa = Avx2<T>;
+		typename Isa::Register needle = Isa::Broadcast(value);
+		size_t matches = 0;
+		size_t i = 0;
+		for (; i + Isa::WIDTH <= count; i += Isa::WIDTH) { matches += __builtin_popcount(Isa::EqualMask(Isa::Load(data + i), needle)); }
+		return matches + ScalarCount(data + i, count - i, value);
+	}
+
+	template <typename T>
+	SIMD_TARGET_AVX2 void Avx2MinMax(const T* data, size_t count, T& min, T& max) noexcept {
+		using Isa = Avx2<T>;
+		typename Isa::Register low = Isa::Load(data);
+		typename Isa::Register high = low;
+		size_t i = Isa::WIDTH;
+		for (; i + Isa::WIDTH <= count; i += Isa::WIDTH) {
+			typename Isa::Register values = Isa::Load(data + i);
+			low = Isa::Min(low, values);
+			high = Isa::Max(high, values);
+		}
+		T lows[Isa::WIDTH];
+		T highs[Isa::WIDTH];
+		Isa::Store(lows, low);
+		Isa::Store(highs, high);
+		min = lows[0];
+		max = highs[0];
+		ScalarMinMax(lows, Isa::WIDTH, min, max);
+		ScalarMinMax(highs, Isa::WIDTH, min, max);
+		ScalarMinMax(data + i, count - i, min, max);
+	}
+
+	template <typename T>
+	SIMD_TARGET_AVX512 size_t Avx512Find(const T* data, size_t count, T value) noexcept {
+		using Isa = Avx512<T>;
+		typename Isa::Register needle = Isa::Broadcast(value);
+		size_t i = 0;
+		for (; i + Isa::WIDTH <= count; i += Isa::WIDTH) {
+			if (uint32_t mask = Isa::EqualMask(Isa::Load(data + i), needle)) { return i + __builtin_ctz(mask); }
+		}
+		size_t tail = ScalarFind(data + i, count - i, value);
+		return tail == SEARCH_NPOS ? SEARCH_NPOS : i + tail;
+	}
+
+	template <typename T>
+	SIMD_TARGET_AVX512 size_t Avx512Count(const T* data, size_t count, T value) noexcept {
+		using Isa = Avx512<T>;
+		typename Isa::Register needle = Isa::Broadcast(value);
+		size_t matches = 0;
+		size_t i = 0;
+		for (; i + Isa::WIDTH <= count; i += Isa::WIDTH) { matches += __builtin_popcount(Isa::EqualMask(Isa::Load(data + i), needle)); }
+		return matches + ScalarCount(data + i, count - i, value);
+	}
+
+	template <typename T>
+	SIMD_TARGET_AVX512 void Avx512MinMax(const T* data, size_t count, T& min, T& max) noexcept {
+		using Isa = Avx512<T>;
+		typename Isa::Register low = Isa::Load(data);
+		typename Isa::Register high = low;
+		size_t i = Isa::WIDTH;
+		for (; i + Isa::WIDTH <= count; i += Isa::WIDTH) {
+			typename Isa::Register values = Isa::Load(data + i);
+			low = Isa::Min(low, values);
+			high = Isa::Max(high, values);
+		}
+		T lows[Isa::WIDTH];
+		T highs[Isa::WIDTH];
+		Isa::Store(lows, low);
+		Isa::Store(highs, high);
+		min = lows[0];
+		max = highs[0];
+		ScalarMinMax(lows, Isa::WIDTH, min, max);
+		ScalarMinMax(highs, Isa::WIDTH, min, max);
+		ScalarMinMax(data + i, count - i, min, max);
+	}
+
+#endif
+
+	// --- Dispatch ---
+
+	template <typename T>
+	size_t Find(const T* data, size_t count, const T& value) noexcept {
+#if VECTOR_SIMD_X86
+		if constexpr (IS_SIMD_ELEMENT<T>) {
+			switch (ActiveSimdLevel()) {
+				case SimdLevel::AVX512: return Avx512Find(data, count, value);
+				case SimdLevel::AVX2:   return Avx2Find(data, count, value);
+				case SimdLevel::SSE42:  return Sse42Find(data, count, value);
+				case SimdLevel::SCALAR: break;
+			}
+		}
+#endif
+		return ScalarFind(data, count, value);
+	}
+
+	template <typename T>
+	size_t Count(const T* data, size_t count, const T& value) noexcept {
+#if VECTOR_SIMD_X86
+		if constexpr (IS_SIMD_ELEMENT<T>) {
+			switch (ActiveSimdLevel()) {
+				case SimdLevel::AVX512: return Avx512Count(data, count, value);
+				case SimdLevel::AVX2:   return Avx2Count(data, count, value);
+				case SimdLevel::SSE42:  return Sse42Count(data, count, value);
+				case SimdLevel::SCALAR: break;
+			}
+		}
+#endif
+		return ScalarCount(data, count, value);
+	}
+
+	template <typename T>
+	std::pair<T, T> MinMax(const T* data, size_t count) {
+		assert(count > 0);
+		T min = data[0];
+		T max = data[0];
+#if VECTOR_SIMD_X86
+		if constexpr (IS_SIMD_ELEMENT<T>) {
+			SimdLevel level = ActiveSimdLevel();
+			if (level == SimdLevel::AVX512 && count >= Avx512<T>::WIDTH) { Avx512MinMax(data, count, min, max); return { min, max }; }
+			if (level >= SimdLevel::AVX2   && count >= Avx2<T>::WIDTH)   { Avx2MinMax(data, count, min, max);   return { min, max }; }
+			if (level >= SimdLevel::SSE42  && count >= Sse42<T>::WIDTH)  { Sse42MinMax(data, count, min, max);  return { min, max }; }
+		}
+#endif
+		ScalarMinMax(data + 1, count - 1, min, max);
+		return { min, max };
+	}
+
+}  // namespace search_detail
+
+template <typename T>
+size_t Find(Span<const T> range, const typename search_detail::NonDeduced<T>::Type& value) noexcept {	// Index of the first match or SEARCH_NPOS
+	return search_detail::Find(range.GetAddress(), range.Size(), value);
+}
+
+template <typename T>
+size_t Count(Span<const T> range, const typename search_detail::NonDeduced<T>::Type& value) noexcept {
+	return search_detail::Count(range.GetAddress(), range.Size(), value);
+}
+
+template <typename T>
+bool Contains(Span<const T> range, const typename search_detail::NonDeduced<T>::Type& value) noexcept {
+	return Find(range, value) != SEARCH_NPOS;
+}
+
+template <typename T>
+std::pair<T, T> MinMax(Span<const T> range) {	// Range must not be empty
+	return search_detail::MinMax(range.GetAddress(), range.Size());
+}
+
+template <typename T>
+size_t ArgMin(Span<const T> range) {	// Index of the first minimum - a vectorized min pass, then a vectorized find
+	return Find(range, MinMax(range).first);
+}
+
+template <typename T, typename Allocator>
+size_t Find(const Vector<T, Allocator>& vector, const typename search_detail::NonDeduced<T>::Type& value) noexcept { return Find(vector.AsSpan(), value); }
+
+template <typename T, typename Allocator>
+size_t Count(const Vector<T, Allocator>& vector, const typename search_detail::NonDeduced<T>::Type& value) noexcept { return Count(vector.AsSpan(), value); }
+
+template <typename T, typename Allocator>
+bool Contains(const Vector<T, Allocator>& vector, const typename search_detail::NonDeduced<T>::Type& value) noexcept { return Contains(vector.AsSpan(), value); }
+
+template <typename T, typename Allocator>
+std::pair<T, T> MinMax(const Vector<T, Allocator>& vector) { return MinMax(vector.AsSpan()); }
+
+template <typename T, typename Allocator>
+size_t ArgMin(const Vector<T, Allocator>& vector) { return ArgMin(vector.AsSpan()); }
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "vector.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <functional>
+#include <type_traits>
+
+// Partial selection without sorting the whole input. TopK keeps a bounded heap whose root is the
+// worst element kept so far; once the heap is full, arithmetic inputs are screened a block at a
+// time with a branch-free "does anything beat the root" loop that the compiler vectorizes, and only
+// blocks holding a candidate touch the heap. On random data almost every block is skipped.
+
+namespace selection_detail {
+
+	inline constexpr size_t FILTER_BLOCK = 64;				// Elements screened against the heap root at once
+	inline constexpr size_t PARALLEL_MIN_SIZE = 1 << 16;
+
+	template <typename T, typename Compare>
+	void ReplaceRoot(Vector<T>& heap, const T& value, Compare& compare) {
+		std::pop_heap(heap.begin(), heap.end(), compare);
+		heap[heap.Size() - 1] = value;
+		std::push_heap(heap.begin(), heap.end(), compare);
+	}
+
+	template <typename T, typename Compare>
+	void SelectInto(Vector<T>& heap, const T* data, size_t count, size_t k, Compare& compare) {	// heap - max-heap under compare, at most k elements
+		size_t i = 0;
+		for (; i < count && heap.Size() < k; ++i) {
+			heap.PushBack(data[i]);
+			std::push_heap(heap.begin(), heap.end(), compare);
+		}
+		while (i < count) {
+			size_t block_end = std::min(i + FILTER_BLOCK, count);
+			if constexpr (std::is_arithmetic_v<T>) {
+				const T threshold = heap[0];
+				bool candidate = false;
+				for (size_t j = i; j < block_end; ++j) { candidate |= compare(data[j], threshold); }
+				if (!candidate) {
+					i = block_end;
+					continue;
+				}
+			}
+			for (; i < block_end; ++i) {
+				if (compare(data[i], heap[0])) { ReplaceRoot(heap, data[i], compare); }
+			}
+		}
+	}
+
+	template <typename T, typename Compare>
+	Vector<T> Finish(Vector<T>& heap, Compare& compare) {	// Best first
+		std::sort_heap(heap.begin(), heap.end(), compare);
+		return std::move(heap);
+	}
+
+}  // namespace selection_detail
+
+template <typename T, typename Compare = std::greater<>>
+Vector<T> TopK(Span<const T> range, size_t k, Compare compare = Compare()) {	// The k first elements under compare, best first - by default the k largest
+	k = std::min(k, range.Size());
+	Vector<T> heap;
+	heap.Reserve(k);
+	if (k > 0) { selection_detail::SelectInto(heap, range.GetAddress(), range.Size(), k, compare); }
+	return selection_detail::Finish(heap, compare);
+}
+
+template <typename T, typename Allocator, typename Compare = std::greater<>>
+Vector<T> TopK(const Vector<T, Allocator>& vector, size_t k, Compare compare = Compare()) {
+	return TopK(vector.AsSpan(), k, std::move(compare));
+}
+
+template <typename T, typename Compare = std::greater<>>
+Vector<T> ParallelTopK(Span<const T> range, size_t k, Compare compare = Compare(), ThreadPool& pool = ThreadPool::Shared()) {	// Per-task top-k, then the top-k of their union
+	k = std::min(k, range.Size());
+	if (k == 0 || range.Size() < selection_detail::PARALLEL_MIN_SIZE) { return TopK(range, k, compare); }
+
+	size_t tasks = (pool.ThreadCount() + 1) * parallel_detail::TASKS_PER_THREAD;
+	size_t grain = std::max((range.Size() + tasks - 1) / tasks, k);	// every chunk but the last holds at least k elements
+	size_t chunks = (range.Size() + grain - 1) / grain;
+	Vector<Vector<T>> partials(chunks);
+	ParallelFor(chunks, [&](size_t first, size_t last) {
+		for (size_t chunk = first; chunk < last; ++chunk) {
+			size_t begin = chunk * grain;
+			partials[chunk] = TopK(range.Subspan(begin, std::min(grain, range.Size() - begin)), k, compare);
+		}
+	}, 1, pool);
+
+	Vector<T> heap;
+	heap.Reserve(k);
+	for (const Vector<T>& partial : partials) { selection_detail::SelectInto(heap, partial.begin(), partial.Size(), k, compare); }
+	return selection_detail::Finish(heap, compare);
+}
+
+template <typename T, typename Allocator, typename Compare = std::greater<>>
+Vector<T> ParallelTopK(const Vector<T, Allocator>& vector, size_t k, Compare compare = Compare(), ThreadPool& pool = ThreadPool::Shared()) {
+	return ParallelTopK(vector.AsSpan(), k, std::move(compare), pool);
+}
+
+template <typename T, typename Compare = std::less<>>
+void NthElement(Span<T> range, size_t n, Compare compare = Compare()) {	// In place: range[n] ends up as in a sorted range, nothing before it is greater, nothing after it is less
+	assert(n < range.Size());
+	std::nth_element(range.begin(), range.begin() + n, range.end(), compare);	// introselect, O(N) on average
+}
+
+template <typename T, typename Allocator, typename Compare = std::less<>>
+void NthElement(Vector<T, Allocator>& vector, size_t n, Compare compare = Compare()) {
+	NthElement(vector.AsSpan(), n, std::move(compare));
+}
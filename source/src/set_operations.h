@@ -0,0 +1,233 @@
+#pragma once
+
+#include "vector.h"
+#include "simd.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+
+// Set algebra on sorted, duplicate-free ranges such as posting lists. Inputs of similar size are
+// compared a block at a time: every element of an A block is matched against all rotations of a
+// B block with SIMD equality, and the block with the smaller maximum moves on. When one side is
+// GALLOP_RATIO times longer, each element of the short side is located by galloping instead.
+
+namespace set_operations_detail {
+
+	inline constexpr size_t GALLOP_RATIO = 32;
+
+	template <typename T>
+	inline constexpr bool IS_SIMD_ELEMENT = std::is_same_v<T, uint32_t> || std::is_same_v<T, uint64_t>;
+
+	template <typename T>
+	const T* Gallop(const T* first, const T* last, const T& value) noexcept {	// lower_bound that is cheap when the answer is near first
+		size_t size = static_cast<size_t>(last - first);
+		size_t step = 1;
+		while (step < size && first[step] < value) { step *= 2; }
+		return std::lower_bound(first + step / 2, first + std::min(step, size), value);
+	}
+
+	// --- Scalar merges, count only when out is nullptr ---
+
+	template <typename T>
+	size_t ScalarIntersect(const T* a, size_t a_size, const T* b, size_t b_size, Vector<T>* out) {
+		size_t i = 0, j = 0, count = 0;
+		while (i < a_size && j < b_size) {
+			if (a[i] < b[j])      { ++i; }
+			else if (b[j] < a[i]) { ++j; }
+			else {
+				if (out != nullptr) { out->PushBack(a[i]); }
+				++count;
+				++i;
+				++j;
+			}
+		}
+		return count;
+	}
+
+	template <typename T>
+	void ScalarDifference(const T* a, size_t a_size, const T* b, size_t b_size, Vector<T>& out) {
+		size_t i = 0, j = 0;
+		while (i < a_size && j < b_size) {
+			if (a[i] < b[j])      { out.PushBack(a[i++]); }
+			else if (b[j] < a[i]) { ++j; }
+			else                  { ++i; ++j; }
+		}
+		for (; i < a_size; ++i) { out.PushBack(a[i]); }
+	}
+
+	template <typename T>
+	size_t GallopIntersect(const T* small, size_t small_size, const T* large, size_t large_size, Vector<T>* out) {
+		const T* position = large;
+		const T* end = large + large_size;
+		size_t count = 0;
+		for (size_t i = 0; i < small_size && position != end; ++i) {
+			position = Gallop(position, end, small[i]);
+			if (position != end && *position == small[i]) {
+				if (out != nullptr) { out->PushBack(small[i]); }
+				++count;
+			}
+		}
+		return count;
+	}
+
+#if VECTOR_SIMD_X86
+
+	template <typename T> struct Avx2Block;
+
+	template <> struct Avx2Block<uint32_t> {
+		static constexpr size_t WIDTH = 8;
+		SIMD_INLINE_AVX2 static uint32_t Matches(const uint32_t* a, const uint32_t* b) noexcept {	// bit i - a[i] occurs in b[0..7]
+			__m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a));
+			__m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b));
+			__m256i rotate = _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 0);
+			__m256i found = _mm256_cmpeq_epi32(va, vb);
+			for (int r = 1; r < 8; ++r) {
+				vb = _mm256_permutevar8x32_epi32(vb, rotate);
+				found = _mm256_or_si256(found, _mm256_cmpeq_epi32(va, vb));
+			}
+			return static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(found)));
+		}
+	};
+
+	template <> struct Avx2Block<uint64_t> {
+		static constexpr size_t WIDTH = 4;
+		SIMD_INLINE_AVX2 static uint32_t Matches(const uint64_t* a, const uint64_t* b) noexcept {
+			__m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a));
+			__m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b));
+			__m256i found = _mm256_cmpeq_epi64(va, vb);
+			found = _mm256_or_si256(found, _mm256_cmpeq_epi64(va, _mm256_permute4x64_epi64(vb, _MM_SHUFFLE(0, 3, 2, 1))));
+			found = _mm256_or_si256(found, _mm256_cmpeq_epi64(va, _mm256_permute4x64_epi64(vb, _MM_SHUFFLE(1, 0, 3, 2))));
+			found = _mm256_or_si256(found, _mm256_cmpeq_epi64(va, _mm256_permute4x64_epi64(vb, _MM_SHUFFLE(2, 1, 0, 3))));
+			return static_cast<uint32_t>(_mm256_movemask_pd(_mm256_castsi256_pd(found)));
+		}
+	};
+
+	template <bool DIFFERENCE, typename T>
+	SIMD_TARGET_AVX2 size_t Avx2Blocks(const T* a, size_t a_size, const T* b, size_t b_size, Vector<T>* out, size_t& i, size_t& j) {
+		// Intersection (or A \ B) of the full blocks, i and j end on the first unprocessed elements
+		constexpr size_t W = Avx2Block<T>::WIDTH;
+		constexpr uint32_t ALL = (1u << W) - 1;
+		size_t count = 0;
+		uint32_t found = 0;		// matches of the current A block collected over every B block it overlapped
+		while (i + W <= a_size && j + W <= b_size) {
+			found |= Avx2Block<T>::Matches(a + i, b + j);
+			T a_max = a[i + W - 1];
+			T b_max = b[j + W - 1];
+			if (a_max <= b_max) {		// no later B block can match this A block
+				uint32_t emit = DIFFERENCE ? ~found & ALL : found;
+				count += __builtin_popcount(emit);
+				if (out != nullptr) {
+					for (; emit != 0; emit &= emit - 1) { out->PushBack(a[i + __builtin_ctz(emit)]); }
+				}
+				found = 0;
+				i += W;
+			}
+			if (b_max <= a_max) { j += W; }
+		}
+		if (found != 0) { j = static_cast<size_t>(std::lower_bound(b, b + j, a[i]) - b); }	// the A block is redone by the scalar tail
+		return count;
+	}
+
+#endif
+
+	template <typename T>
+	size_t Intersect(Span<const T> a, Span<const T> b, Vector<T>* out) {
+		if (a.Size() > b.Size()) { std::swap(a, b); }		// a is the short side, the output is in order either way
+		if (a.Size() == 0) { return 0; }
+		if (b.Size() / a.Size() >= GALLOP_RATIO) { return GallopIntersect(a.GetAddress(), a.Size(), b.GetAddress(), b.Size(), out); }
+		size_t i = 0, j = 0, count = 0;
+#if VECTOR_SIMD_X86
+		if constexpr (IS_SIMD_ELEMENT<T>) {
+			if (ActiveSimdLevel() >= SimdLevel::AVX2) { count = Avx2Blocks<false>(a.GetAddress(), a.Size(), b.GetAddress(), b.Size(), out, i, j); }
+		}
+#endif
+		return count + ScalarIntersect(a.GetAddress() + i, a.Size() - i, b.GetAddress() + j, b.Size() - j, out);
+	}
+
+}  // namespace set_operations_detail
+
+template <typename T>
+Vector<T> Intersect(Span<const T> a, Span<const T> b) {		// Elements in both, ascending
+	Vector<T> result;
+	result.Reserve(std::min(a.Size(), b.Size()));
+	set_operations_detail::Intersect(a, b, &result);
+	return result;
+}
+
+template <typename T>
+size_t IntersectCount(Span<const T> a, Span<const T> b) {	// |a & b| without building the result
+	return set_operations_detail::Intersect<T>(a, b, nullptr);
+}
+
+template <typename T>
+Vector<T> Union(Span<const T> a, Span<const T> b) {			// Elements in either, ascending, each once
+	Vector<T> result;
+	result.Reserve(a.Size() + b.Size());
+	if (a.Size() > b.Size()) { std::swap(a, b); }
+	const T* large = b.begin();
+	const T* large_end = b.end();
+	if (a.Size() > 0 && b.Size() / a.Size() >= set_operations_detail::GALLOP_RATIO) {	// copy whole runs of the long side between short-side elements
+		for (const T& value : a) {
+			const T* next = set_operations_detail::Gallop(large, large_end, value);
+			for (; large != next; ++large) { result.PushBack(*large); }
+			if (large != large_end && *large == value) { ++large; }
+			result.PushBack(value);
+		}
+	}
+	else {
+		const T* small = a.begin();
+		while (small != a.end() && large != large_end) {
+			if (*small < *large)      { result.PushBack(*small++); }
+			else if (*large < *small) { result.PushBack(*large++); }
+			else                      { result.PushBack(*small++); ++large; }
+		}
+		for (; small != a.end(); ++small) { result.PushBack(*small); }
+	}
+	for (; large != large_end; ++large) { result.PushBack(*large); }
+	return result;
+}
+
+template <typename T>
+Vector<T> Difference(Span<const T> a, Span<const T> b) {	// Elements of a missing from b, ascending
+	Vector<T> result;
+	result.Reserve(a.Size());
+	if (a.Size() > 0 && b.Size() / a.Size() >= set_operations_detail::GALLOP_RATIO) {	// short a: look every element up in b
+		const T* position = b.begin();
+		for (const T& value : a) {
+			position = set_operations_detail::Gallop(position, b.end(), value);
+			if (position == b.end() || *position != value) { result.PushBack(value); }
+		}
+		return result;
+	}
+	if (b.Size() > 0 && a.Size() / b.Size() >= set_operations_detail::GALLOP_RATIO) {	// short b: copy the runs of a between its elements
+		const T* position = a.begin();
+		for (const T& value : b) {
+			const T* next = set_operations_detail::Gallop(position, a.end(), value);
+			for (; position != next; ++position) { result.PushBack(*position); }
+			if (position != a.end() && *position == value) { ++position; }
+		}
+		for (; position != a.end(); ++position) { result.PushBack(*position); }
+		return result;
+	}
+	size_t i = 0, j = 0;
+#if VECTOR_SIMD_X86
+	if constexpr (set_operations_detail::IS_SIMD_ELEMENT<T>) {
+		if (ActiveSimdLevel() >= SimdLevel::AVX2) { set_operations_detail::Avx2Blocks<true>(a.GetAddress(), a.Size(), b.GetAddress(), b.Size(), &result, i, j); }
+	}
+#endif
+	set_operations_detail::ScalarDifference(a.GetAddress() + i, a.Size() - i, b.GetAddress() + j, b.Size() - j, result);
+	return result;
+}
+
+template <typename T, typename Allocator>
+Vector<T> Intersect(const Vector<T, Allocator>& a, const Vector<T, Allocator>& b) { return Intersect(a.AsSpan(), b.AsSpan()); }
+
+template <typename T, typename Allocator>
+size_t IntersectCount(const Vector<T, Allocator>& a, const Vector<T, Allocator>& b) { return IntersectCount(a.AsSpan(), b.AsSpan()); }
+
+template <typename T, typename Allocator>
+Vector<T> Union(const Vector<T, Allocator>& a, const Vector<T, Allocator>& b) { return Union(a.AsSpan(), b.AsSpan()); }
+
+template <typename T, typename Allocator>
+Vector<T> Difference(const Vector<T, Allocator>& a, const Vector<T, Allocator>& b) { return Difference(a.AsSpan(), b.AsSpan()); }
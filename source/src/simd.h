@@ -0,0 +1,74 @@
+#pragma once
+
+// Runtime CPU dispatch. Kernels for wider instruction sets are compiled with per-function target
+// attributes, so the binary itself keeps the baseline ISA and still runs on older CPUs.
+
+#include <cstdint>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define VECTOR_SIMD_X86 1
+#include <immintrin.h>
+#define SIMD_TARGET_SSE42  __attribute__((target("sse4.2")))
+#define SIMD_TARGET_AVX2   __attribute__((target("avx2")))
+#define SIMD_TARGET_AVX512 __attribute__((target("avx512f,avx512bw,avx512dq,avx512vl,avx2")))
+#define SIMD_INLINE_SSE42  __attribute__((target("sse4.2"), always_inline)) inline
+#define SIMD_INLINE_AVX2   __attribute__((target("avx2"), always_inline)) inline
+#define SIMD_INLINE_AVX512 __attribute__((target("avx512f,avx512bw,avx512dq,avx512vl,avx2"), always_inline)) inline
+#else
+#define VECTOR_SIMD_X86 0
+#endif
+
+enum class SimdLevel {
+	SCALAR,
+	SSE42,
+	AVX2,
+	AVX512
+};
+
+inline SimdLevel DetectSimdLevel() noexcept {	// Detected once, every later call is a load of a static
+	static const SimdLevel level = [] {
+#if VECTOR_SIMD_X86
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")
+			&& __builtin_cpu_supports("avx512dq") && __builtin_cpu_supports("avx512vl")) { return SimdLevel::AVX512; }
+		if (__builtin_cpu_supports("avx2"))   { return SimdLevel::AVX2; }
+		if (__builtin_cpu_supports("sse4.2")) { return SimdLevel::SSE42; }
+#endif
+		return SimdLevel::SCALAR;
+	}();
+	return level;
+}
+
+inline SimdLevel& SimdLevelOverride() noexcept {	// Tests force lower levels through this to cover every kernel on one machine
+	static SimdLevel level = DetectSimdLevel();
+	return level;
+}
+
+inline SimdLevel ActiveSimdLevel() noexcept {
+	SimdLevel requested = SimdLevelOverride();
+	SimdLevel detected = DetectSimdLevel();
+	return requested < detected ? requested : detected;
+}
+
+// --- Portable prefetch ---
+
+#if defined(__GNUC__)
+#define VECTOR_PREFETCH(address, write) __builtin_prefetch((address), (write))	// write - 0 or 1, a compile-time constant
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <xmmintrin.h>
+#define VECTOR_PREFETCH(address, write) ((void)(write), _mm_prefetch(reinterpret_cast<const char*>(address), _MM_HINT_T0))	// read hint for both
+#else
+#define VECTOR_PREFETCH(address, write) ((void)(address), (void)(write))			// a hint only, dropping it is always correct
+#endif
+
+// --- Portable bit helpers ---
+
+inline unsigned CountTrailingZeros(uint64_t bits) noexcept {	// bits must not be 0
+#if defined(__GNUC__)
+	return static_cast<unsigned>(__builtin_ctzll(bits));
+#else
+	unsigned count = 0;
+	for (; (bits & 1) == 0; bits >>= 1) { ++count; }
+	return count;
+#endif
+}
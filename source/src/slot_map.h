@@ -0,0 +1,134 @@
+#pragma once
+
+#include "vector.h"
+
+#include <cstdint>
+#include <limits>
+
+template <typename T>
+class SlotMap {
+
+	public:
+
+		struct Handle {
+			uint32_t index = std::numeric_limits<uint32_t>::max();	// position in the sparse slot array
+			uint32_t generation = 0;								// generation of the slot at the moment of insertion
+
+			bool operator==(const Handle& other) const noexcept { return index == other.index && generation == other.generation; }
+			bool operator!=(const Handle& other) const noexcept { return !(*this == other); }
+		};
+
+		// --- Constructors ---
+
+		SlotMap() = default;
+
+		// --- "std::vector"-like functions ---
+
+		size_t Size()     const noexcept { return dense_.Size(); }		// Get number of live elements
+		size_t Capacity() const noexcept { return dense_.Capacity(); }	// Get capacity of the dense storage
+		bool   Empty()    const noexcept { return dense_.Size() == 0; }
+
+		void Reserve(size_t new_capacity) {			// Reserve memory in dense and sparse storage at once
+			dense_.Reserve(new_capacity);
+			dense_to_slot_.Reserve(new_capacity);
+			slots_.Reserve(new_capacity);
+		}
+
+		template <typename Type>
+		Handle Insert(Type&& value) { return Emplace(std::forward<Type>(value)); }
+
+		template <typename... Args>
+		Handle Emplace(Args&&... args) {
+			if (free_head_ == NPOS) {											// no free slots - grow the sparse array
+				assert(slots_.Size() < NPOS);
+				slots_.EmplaceBack(Slot{ NPOS, FREE_BIT });						// odd generation - the slot is still free
+				free_head_ = static_cast<uint32_t>(slots_.Size() - 1);
+			}
+			uint32_t slot_index = free_head_;
+
+			uint32_t dense_index = static_cast<uint32_t>(dense_.Size());
+			dense_.EmplaceBack(std::forward<Args>(args)...);					// may throw - the slot has not been touched yet
+			try {
+				dense_to_slot_.PushBack(slot_index);
+			}
+			catch (...) {
+				dense_.PopBack();
+				throw;
+			}
+
+			Slot& slot = slots_[slot_index];
+			free_head_ = slot.index;											// unlink from the free list
+			slot.index = dense_index;
+			++slot.generation;													// even generation - the slot is occupied
+			return Handle{ slot_index, slot.generation };
+		}
+
+		bool Contains(Handle handle) const noexcept {	// Even generations are only ever stored in occupied slots, so a match means the handle is alive
+			return handle.index < slots_.Size() && slots_[handle.index].generation == handle.generation;
+		}
+
+		const T* Get(Handle handle) const noexcept { return const_cast<SlotMap&>(*this).Get(handle); }	// Constancy trick to avoid duplication
+			  T* Get(Handle handle)       noexcept {													// nullptr for stale handles
+			return Contains(handle) ? &dense_[slots_[handle.index].index] : nullptr;
+		}
+
+		const T& operator[](Handle handle) const noexcept { return const_cast<SlotMap&>(*this)[handle]; }	// Constancy trick to avoid duplication of assert
+			  T& operator[](Handle handle)       noexcept { assert(Contains(handle)); return dense_[slots_[handle.index].index]; }
+
+		bool Erase(Handle handle) {
+			if (!Contains(handle)) { return false; }
+
+			Slot& slot = slots_[handle.index];
+			size_t dense_index = slot.index;
+			size_t last = dense_.Size() - 1;
+			if (dense_index != last) {									// swap with the last element to keep dense storage packed
+				dense_[dense_index] = std::move(dense_[last]);
+				dense_to_slot_[dense_index] = dense_to_slot_[last];
+				slots_[dense_to_slot_[dense_index]].index = static_cast<uint32_t>(dense_index);
+			}
+			dense_.PopBack();
+			dense_to_slot_.PopBack();
+
+			++slot.generation;											// odd generation - every handle to this slot is now stale
+			slot.index = free_head_;									// push to the free list
+			free_head_ = handle.index;
+			return true;
+		}
+
+		void Clear() {
+			while (dense_.Size() != 0) {
+				Erase(HandleAt(dense_.Size() - 1));
+			}
+		}
+
+		Handle HandleAt(size_t dense_index) const noexcept {	// Get handle of the element at a position in dense storage
+			assert(dense_index < dense_.Size());
+			uint32_t slot_index = dense_to_slot_[dense_index];
+			return Handle{ slot_index, slots_[slot_index].generation };
+		}
+
+		// --- Iterators (dense storage, order changes on Erase) ---
+
+		T* begin() noexcept { return dense_.begin(); }
+		T* end()   noexcept { return dense_.end()  ; }
+
+		const T* begin()  const noexcept { return dense_.begin(); }
+		const T* end()    const noexcept { return dense_.end()  ; }
+		const T* cbegin() const noexcept { return begin()       ; }
+		const T* cend()   const noexcept { return end()         ; }
+
+	private:
+
+		static constexpr uint32_t NPOS = std::numeric_limits<uint32_t>::max();
+		static constexpr uint32_t FREE_BIT = 1;	// odd generation marks a free slot
+
+		struct Slot {
+			uint32_t index;			// dense index when occupied, next free slot when free
+			uint32_t generation;	// even - occupied, odd - free
+		};
+
+		Vector<T> dense_;					// packed elements for iteration
+		Vector<uint32_t> dense_to_slot_;	// back references from dense storage to slots
+		Vector<Slot> slots_;				// sparse array indexed by Handle::index
+		uint32_t free_head_ = NPOS;			// head of the intrusive free list of slots
+};
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <limits>
+#include <type_traits>
+
+template <typename T>
+class StridedSpan;
+
+template <typename T>
+class Span {	// Non-owning view of contiguous elements, bounds are checked by assert only
+
+	public:
+
+		static constexpr size_t NPOS = std::numeric_limits<size_t>::max();	// "up to the end" for Subspan
+
+		// --- Constructors ---
+
+		constexpr Span() noexcept = default;
+
+		constexpr Span(T* data, size_t size) noexcept
+			: data_(data)
+			, size_(size)
+		{}
+
+		template <typename U, typename = std::enable_if_t<std::is_convertible_v<U(*)[], T(*)[]>>>
+		constexpr Span(const Span<U>& other) noexcept		// Span<T> -> Span<const T>
+			: data_(other.GetAddress())
+			, size_(other.Size())
+		{}
+
+		// --- Operators overloads ---
+
+		constexpr T& operator[](size_t index) const noexcept { assert(index < size_); return data_[index]; }
+
+		// --- Observers ---
+
+		constexpr T*     GetAddress() const noexcept { return data_; }
+		constexpr size_t Size()       const noexcept { return size_; }
+		constexpr bool   Empty()      const noexcept { return size_ == 0; }
+
+		// --- Sub-views (never allocate) ---
+
+		constexpr Span First(size_t count) const noexcept { assert(count <= size_); return Span(data_, count); }
+		constexpr Span Last(size_t count)  const noexcept { assert(count <= size_); return Span(data_ + size_ - count, count); }
+
+		constexpr Span Subspan(size_t offset, size_t count = NPOS) const noexcept {
+			assert(offset <= size_);
+			if (count == NPOS) { count = size_ - offset; }
+			assert(count <= size_ - offset);
+			return Span(data_ + offset, count);
+		}
+
+		constexpr StridedSpan<T> Strided(size_t stride, size_t offset = 0) const noexcept;	// Every stride-th element starting at offset
+
+		// --- Iterators ---
+
+		constexpr T* begin() const noexcept { return data_; }
+		constexpr T* end()   const noexcept { return data_ + size_; }
+
+	private:
+
+		T* data_ = nullptr;
+		size_t size_ = 0;
+};
+
+template <typename T>
+class StridedSpan {	// Non-owning view of every stride-th element, e.g. a column of a row-major matrix
+
+	public:
+
+		class Iterator {
+
+			public:
+
+				using iterator_category = std::random_access_iterator_tag;
+				using value_type = std::remove_cv_t<T>;
+				using difference_type = std::ptrdiff_t;
+				using pointer = T*;
+				using reference = T&;
+
+				constexpr Iterator() noexcept = default;
+				constexpr Iterator(T* data, size_t index, size_t stride) noexcept : data_(data), index_(index), stride_(stride) {}
+
+				constexpr T& operator*()  const noexcept { return data_[index_ * stride_]; }
+				constexpr T* operator->() const noexcept { return data_ + index_ * stride_; }
+				constexpr T& operator[](difference_type n) const noexcept { return data_[(index_ + n) * stride_]; }
+
+				constexpr Iterator& operator++() noexcept { ++index_; return *this; }
+				constexpr Iterator& operator--() noexcept { --index_; return *this; }
+				constexpr Iterator operator++(int) noexcept { Iterator old = *this; ++index_; return old; }
+				constexpr Iterator operator--(int) noexcept { Iterator old = *this; --index_; return old; }
+
+				constexpr Iterator& operator+=(difference_type n) noexcept { index_ += n; return *this; }
+				constexpr Iterator& operator-=(difference_type n) noexcept { index_ -= n; return *this; }
+				constexpr Iterator operator+(difference_type n) const noexcept { return Iterator(*this) += n; }
+				constexpr Iterator operator-(difference_type n) const noexcept { return Iterator(*this) -= n; }
+				friend constexpr Iterator operator+(difference_type n, const Iterator& it) noexcept { return it + n; }
+				constexpr difference_type operator-(const Iterator& other) const noexcept { return static_cast<difference_type>(index_ - other.index_); }
+
+				constexpr bool operator==(const Iterator& other) const noexcept { return index_ == other.index_; }
+				constexpr bool operator!=(const Iterator& other) const noexcept { return index_ != other.index_; }
+				constexpr bool operator<(const Iterator& other)  const noexcept { return index_ < other.index_; }
+				constexpr bool operator>(const Iterator& other)  const noexcept { return index_ > other.index_; }
+				constexpr bool operator<=(const Iterator& other) const noexcept { return index_ <= other.index_; }
+				constexpr bool operator>=(const Iterator& other) const noexcept { return index_ >= other.index_; }
+
+			private:
+
+				T* data_ = nullptr;		// Index instead of a moving pointer, so end() never points past the underlying array
+				size_t index_ = 0;
+				size_t stride_ = 0;
+		};
+
+		// --- Constructors ---
+
+		constexpr StridedSpan() noexcept = default;
+
+		constexpr StridedSpan(T* data, size_t size, size_t stride) noexcept
+			: data_(data)
+			, size_(size)
+			, stride_(stride)
+		{
+			assert(stride != 0);
+		}
+
+		// --- Operators overloads ---
+
+		constexpr T& operator[](size_t index) const noexcept { assert(index < size_); return data_[index * stride_]; }
+
+		// --- Observers ---
+
+		constexpr T*     GetAddress() const noexcept { return data_; }
+		constexpr size_t Size()       const noexcept { return size_; }
+		constexpr size_t Stride()     const noexcept { return stride_; }
+		constexpr bool   Empty()      const noexcept { return size_ == 0; }
+
+		constexpr StridedSpan Subspan(size_t offset, size_t count) const noexcept {
+			assert(offset <= size_ && count <= size_ - offset);
+			return StridedSpan(data_ + offset * stride_, count, stride_);
+		}
+
+		// --- Iterators ---
+
+		constexpr Iterator begin() const noexcept { return Iterator(data_, 0, stride_)    ; }
+		constexpr Iterator end()   const noexcept { return Iterator(data_, size_, stride_); }
+
+	private:
+
+		T* data_ = nullptr;
+		size_t size_ = 0;
+		size_t stride_ = 1;
+};
+
+template <typename T>
+constexpr StridedSpan<T> Span<T>::Strided(size_t stride, size_t offset) const noexcept {
+	assert(stride != 0 && offset <= size_);
+	size_t count = size_ == offset ? 0 : (size_ - offset + stride - 1) / stride;
+	return StridedSpan<T>(data_ + offset, count, stride);
+}
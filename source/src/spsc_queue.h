@@ -0,0 +1,135 @@
+#pragma once
+
+#include "vector.h"
+#include "cache_line.h"
+
+#include <algorithm>
+#include <atomic>
+
+template <typename T>
+class SpscQueue {	// Lock-free queue for exactly one producer thread and one consumer thread
+
+	public:
+
+		// --- Constructors ---
+
+		explicit SpscQueue(size_t min_capacity)	// Capacity is rounded up to a power of two
+			: data_(RoundUpToPowerOfTwo(min_capacity))
+			, mask_(data_.Capacity() - 1)
+		{}
+
+		SpscQueue(const SpscQueue&) = delete;
+		SpscQueue& operator=(const SpscQueue&) = delete;
+
+		// --- Destructor ---
+
+		~SpscQueue() {
+			size_t tail = tail_.load(std::memory_order_relaxed);
+			for (size_t head = head_.load(std::memory_order_relaxed); head != tail; ++head) {
+				std::destroy_at(data_ + (head & mask_));
+			}
+		}
+
+		// --- Producer functions ---
+
+		template <typename Type>
+		bool TryPush(Type&& value) { return TryEmplace(std::forward<Type>(value)); }
+
+		template <typename... Args>
+		bool TryEmplace(Args&&... args) {	// false if the queue is full
+			size_t tail = tail_.load(std::memory_order_relaxed);
+			if (tail - cached_head_ == Capacity()) {
+				cached_head_ = head_.load(std::memory_order_acquire);	// touch the consumer line only when the cached copy says full
+				if (tail - cached_head_ == Capacity()) { return false; }
+			}
+			new (data_ + (tail & mask_)) T(std::forward<Args>(args)...);
+			tail_.store(tail + 1, std::memory_order_release);
+			return true;
+		}
+
+		template <typename InputIt>
+		size_t TryPushBatch(InputIt first, size_t count) {	// Copies up to count elements, publishes them with one store
+			size_t tail = tail_.load(std::memory_order_relaxed);
+			if (Capacity() - (tail - cached_head_) < count) {
+				cached_head_ = head_.load(std::memory_order_acquire);
+			}
+			size_t pushed = std::min(count, Capacity() - (tail - cached_head_));
+			size_t i = 0;
+			try {
+				for (; i < pushed; ++i, ++first) {
+					new (data_ + ((tail + i) & mask_)) T(*first);
+				}
+			}
+			catch (...) {
+				tail_.store(tail + i, std::memory_order_release);	// publish what was constructed
+				throw;
+			}
+			tail_.store(tail + pushed, std::memory_order_release);
+			return pushed;
+		}
+
+		// --- Consumer functions ---
+
+		bool TryPop(T& value) {		// false if the queue is empty
+			size_t head = head_.load(std::memory_order_relaxed);
+			if (head == cached_tail_) {
+				cached_tail_ = tail_.load(std::memory_order_acquire);	// touch the producer line only when the cached copy says empty
+				if (head == cached_tail_) { return false; }
+			}
+			T* slot = data_ + (head & mask_);
+			value = std::move(*slot);
+			std::destroy_at(slot);
+			head_.store(head + 1, std::memory_order_release);
+			return true;
+		}
+
+		template <typename OutputIt>
+		size_t TryPopBatch(OutputIt out, size_t max_count) {	// Moves up to max_count elements, frees their slots with one store
+			size_t head = head_.load(std::memory_order_relaxed);
+			if (cached_tail_ - head < max_count) {
+				cached_tail_ = tail_.load(std::memory_order_acquire);
+			}
+			size_t popped = std::min(max_count, cached_tail_ - head);
+			size_t i = 0;
+			try {
+				for (; i < popped; ++i, ++out) {
+					T* slot = data_ + ((head + i) & mask_);
+					*out = std::move(*slot);
+					std::destroy_at(slot);
+				}
+			}
+			catch (...) {
+				head_.store(head + i, std::memory_order_release);	// free what was destroyed, the failed element stays queued
+				throw;
+			}
+			head_.store(head + popped, std::memory_order_release);
+			return popped;
+		}
+
+		// --- Observers ---
+
+		size_t Capacity() const noexcept { return data_.Capacity(); }
+
+		size_t SizeApprox() const noexcept {	// Exact only when neither side is running
+			size_t head = head_.load(std::memory_order_acquire);
+			size_t tail = tail_.load(std::memory_order_acquire);
+			return tail - head;
+		}
+
+	private:
+
+		static size_t RoundUpToPowerOfTwo(size_t n) noexcept {
+			size_t result = 1;
+			while (result < n) { result <<= 1; }
+			return result;
+		}
+
+		RawMemory<T> data_;		// Allocated raw memory, capacity is a power of two
+		size_t mask_;			// Capacity - 1
+
+		alignas(CACHE_LINE_SIZE) std::atomic<size_t> head_{ 0 };	// Written by the consumer
+		size_t cached_tail_ = 0;									// Consumer's copy of tail_
+
+		alignas(CACHE_LINE_SIZE) std::atomic<size_t> tail_{ 0 };	// Written by the producer
+		size_t cached_head_ = 0;									// Producer's copy of head_, the class alignment pads this line
+};
@@ -0,0 +1,156 @@
+#pragma once
+
+#include "vector.h"
+#include "simd.h"
+
+#include <cstdint>
+#include <iterator>
+
+template <typename T>
+class TombstoneVector {	// Erase only marks a slot dead, dead slots are squeezed out in one batch pass
+
+	static constexpr size_t WORD_BITS = 64;
+
+	template <typename Owner, typename Value>
+	class BasicIterator {
+
+		public:
+
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = T;
+			using difference_type = std::ptrdiff_t;
+			using pointer = Value*;
+			using reference = Value&;
+
+			BasicIterator(Owner* owner, size_t slot) noexcept : owner_(owner), slot_(slot) {}
+
+			reference operator*()  const noexcept { return owner_->data_[slot_]; }
+			pointer   operator->() const noexcept { return &owner_->data_[slot_]; }
+
+			BasicIterator& operator++() noexcept { slot_ = owner_->NextAlive(slot_ + 1); return *this; }
+			BasicIterator operator++(int) noexcept { BasicIterator old = *this; ++*this; return old; }
+
+			bool operator==(const BasicIterator& other) const noexcept { return slot_ == other.slot_; }
+			bool operator!=(const BasicIterator& other) const noexcept { return slot_ != other.slot_; }
+
+			size_t Slot() const noexcept { return slot_; }	// Slot index to pass to Erase
+
+		private:
+
+			Owner* owner_;
+			size_t slot_;
+	};
+
+	public:
+
+		using Iterator = BasicIterator<TombstoneVector, T>;
+		using ConstIterator = BasicIterator<const TombstoneVector, const T>;
+
+		// --- Constructors ---
+
+		TombstoneVector() = default;
+
+		explicit TombstoneVector(double compaction_threshold)	// Dead ratio in (0, 1] that triggers compaction
+			: compaction_threshold_(compaction_threshold)
+		{
+			assert(compaction_threshold > 0 && compaction_threshold <= 1);
+		}
+
+		// --- "std::vector"-like functions ---
+
+		size_t Size()      const noexcept { return data_.Size() - dead_count_; }	// Number of live elements
+		size_t SlotCount() const noexcept { return data_.Size(); }				// Live and dead slots
+		size_t DeadCount() const noexcept { return dead_count_; }
+		size_t Capacity()  const noexcept { return data_.Capacity(); }
+
+		void Reserve(size_t new_capacity) {
+			data_.Reserve(new_capacity);
+			dead_bits_.Reserve((new_capacity + WORD_BITS - 1) / WORD_BITS);
+		}
+
+		template <typename Type>
+		void PushBack(Type&& value) { EmplaceBack(std::forward<Type>(value)); }
+
+		template <typename... Args>
+		T& EmplaceBack(Args&&... args) {
+			if (data_.Size() == dead_bits_.Size() * WORD_BITS) { dead_bits_.PushBack(uint64_t{ 0 }); }
+			return data_.EmplaceBack(std::forward<Args>(args)...);
+		}
+
+		bool IsAlive(size_t slot) const noexcept {
+			assert(slot < data_.Size());
+			return (dead_bits_[slot / WORD_BITS] & Bit(slot)) == 0;
+		}
+
+		const T& operator[](size_t slot) const noexcept { return const_cast<TombstoneVector&>(*this)[slot]; }	// Constancy trick to avoid duplication of assert
+			  T& operator[](size_t slot)       noexcept { assert(IsAlive(slot)); return data_[slot]; }
+
+		bool Erase(size_t slot) {	// O(1), may trigger compaction which renumbers slots
+			if (!IsAlive(slot)) { return false; }
+			dead_bits_[slot / WORD_BITS] |= Bit(slot);
+			++dead_count_;
+			if (static_cast<double>(dead_count_) > compaction_threshold_ * static_cast<double>(data_.Size())) { Compact(); }
+			return true;
+		}
+
+		template <typename Predicate>
+		size_t EraseIf(Predicate predicate) {	// Mark every matching element, compact at most once at the end
+			size_t erased = 0;
+			for (size_t slot = NextAlive(0); slot < data_.Size(); slot = NextAlive(slot + 1)) {
+				if (predicate(std::as_const(data_[slot]))) {
+					dead_bits_[slot / WORD_BITS] |= Bit(slot);
+					++erased;
+				}
+			}
+			dead_count_ += erased;
+			if (static_cast<double>(dead_count_) > compaction_threshold_ * static_cast<double>(data_.Size())) { Compact(); }
+			return erased;
+		}
+
+		void Compact() {	// Move live elements down in order and destroy the tail in one pass
+			if (dead_count_ == 0) { return; }
+			size_t write = NextDead(0);
+			for (size_t read = NextAlive(write); read < data_.Size(); read = NextAlive(read + 1)) {
+				data_[write++] = std::move(data_[read]);
+			}
+			data_.Truncate(write);
+			for (size_t i = 0; i < dead_bits_.Size(); ++i) { dead_bits_[i] = 0; }
+			dead_count_ = 0;
+		}
+
+		// --- Iterators (skip dead slots) ---
+
+		Iterator begin() noexcept { return Iterator(this, NextAlive(0)); }
+		Iterator end()   noexcept { return Iterator(this, data_.Size()); }
+
+		ConstIterator begin()  const noexcept { return ConstIterator(this, NextAlive(0)); }
+		ConstIterator end()    const noexcept { return ConstIterator(this, data_.Size()); }
+		ConstIterator cbegin() const noexcept { return begin(); }
+		ConstIterator cend()   const noexcept { return end()  ; }
+
+	private:
+
+		static uint64_t Bit(size_t slot) noexcept { return uint64_t{ 1 } << (slot % WORD_BITS); }
+
+		template <bool Dead>
+		size_t NextSlot(size_t slot) const noexcept {	// Scan the bitmap a word at a time, all-dead (or all-alive) words are skipped whole
+			size_t word = slot / WORD_BITS;
+			size_t words = dead_bits_.Size();
+			if (word >= words) { return data_.Size(); }
+			uint64_t bits = (Dead ? dead_bits_[word] : ~dead_bits_[word]) & (~uint64_t{ 0 } << (slot % WORD_BITS));
+			while (bits == 0) {
+				if (++word == words) { return data_.Size(); }
+				bits = Dead ? dead_bits_[word] : ~dead_bits_[word];
+			}
+			size_t result = word * WORD_BITS + static_cast<size_t>(CountTrailingZeros(bits));
+			return result < data_.Size() ? result : data_.Size();
+		}
+
+		size_t NextAlive(size_t slot) const noexcept { return NextSlot<false>(slot); }
+		size_t NextDead(size_t slot)  const noexcept { return NextSlot<true>(slot); }
+
+		Vector<T> data_;				// Live and dead elements in insertion order
+		Vector<uint64_t> dead_bits_;	// One bit per slot, set for dead slots
+		size_t dead_count_ = 0;
+		double compaction_threshold_ = 0.5;
+};
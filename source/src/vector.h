@@ -1,21 +1,51 @@
+#pragma once
+
+#include "span.h"
+#include "hash.h"
+
+#include <algorithm>
 #include <cassert>
 #include <cstdlib>
+#include <cstring>
+#include <functional>
 #include <new>
+#include <type_traits>
 #include <utility>
 #include <memory>
 
-template <typename T>
-class RawMemory {
+template <typename T, typename Allocator = std::allocator<T>>
+class RawMemory : private Allocator {	// Empty base optimization - stateless allocators take no space
 	public:
 
+		using AllocatorTraits = std::allocator_traits<Allocator>;
+
 		RawMemory() = default;
 
-		explicit RawMemory(size_t capacity) 
-			: buffer_(Allocate(capacity))	// Allocates raw memory for n elements and returns a pointer to it
+		explicit RawMemory(const Allocator& alloc)
+			: Allocator(alloc)
+		{}
+
+		explicit RawMemory(size_t capacity, const Allocator& alloc = Allocator()) 
+			: Allocator(alloc)
+			, buffer_(Allocate(capacity))	// Allocates raw memory for n elements and returns a pointer to it
 			, capacity_(capacity)
 		{}
 
-		~RawMemory() { Deallocate(buffer_); }
+		RawMemory(const RawMemory&) = delete;
+		RawMemory& operator=(const RawMemory& rhs) = delete;
+
+		RawMemory(RawMemory&& other) noexcept 
+			: Allocator(other.GetAllocator())
+		{ 
+			Swap(other); 
+		}
+
+		RawMemory& operator=(RawMemory&& rhs) noexcept {
+			if (this != &rhs) { Swap(rhs); }	// checking for self-assignment, swap
+			return *this;
+		}
+
+		~RawMemory() { Deallocate(buffer_, capacity_); }
 
 		T* operator+(size_t offset) noexcept {
 			assert(offset <= capacity_);		// Check if the offset exceeds the capacity
@@ -36,6 +66,7 @@ class RawMemory {
 		}
 
 		void Swap(RawMemory& other) noexcept {
+			std::swap(static_cast<Allocator&>(*this), static_cast<Allocator&>(other));
 			std::swap(buffer_, other.buffer_);
 			std::swap(capacity_, other.capacity_);
 		}
@@ -43,24 +74,29 @@ class RawMemory {
 		const T* GetAddress() const noexcept { return buffer_; }	// Get const pointer to allocated memory
 			  T* GetAddress()       noexcept { return buffer_; }	// Get pointer to allocated memory
 
+		const Allocator& GetAllocator() const noexcept { return *this; }
+
 		size_t Capacity() const { return capacity_; }
 
 	private:
 
-		static T* Allocate(size_t n) {		// Allocates raw memory for n elements and returns a pointer to it
+		T* Allocate(size_t n) {		// Allocates raw memory for n elements and returns a pointer to it
 			return n != 0
-				? static_cast<T*>(operator new(n * sizeof(T))) 
+				? AllocatorTraits::allocate(static_cast<Allocator&>(*this), n)
 				: nullptr;
 		}
-		static void Deallocate(T* buffer) noexcept {		// Frees raw memory previously allocated at buf using Allocate
-			operator delete(buffer); 
+		void Deallocate(T* buffer, size_t n) noexcept {		// Frees raw memory previously allocated at buf using Allocate
+			if (buffer != nullptr) { AllocatorTraits::deallocate(static_cast<Allocator&>(*this), buffer, n); }
 		}
 
 		T* buffer_ = nullptr;		// Pointer to allocated raw memory for n elements
 		size_t capacity_ = 0;
 };
 
-template <typename T>
+template <typename T>	// operator== and std::hash of these look only at the bytes, so whole buffers can be compared and hashed at once
+inline constexpr bool IS_BITWISE_COMPARABLE = std::is_integral_v<T> || std::is_enum_v<T> || std::is_pointer_v<T>;
+
+template <typename T, typename Allocator = std::allocator<T>>
 class Vector {
 
 	public:
@@ -69,8 +105,12 @@ class Vector {
 
 		Vector() = default;
 
-		explicit Vector(size_t size) 
-			: data_(size)
+		explicit Vector(const Allocator& alloc)
+			: data_(alloc)
+		{}
+
+		explicit Vector(size_t size, const Allocator& alloc = Allocator()) 
+			: data_(size, alloc)
 			, size_(size) 
 		{ 
 			std::uninitialized_value_construct_n(	// Constructs n objects in the uninitialized storage starting at first by value-initialization
@@ -79,7 +119,11 @@ class Vector {
 		}
 
 		Vector(const Vector& other) 
-			: data_(other.size_), size_(other.size_) 
+			: Vector(other, other.GetAllocator())
+		{}
+
+		Vector(const Vector& other, const Allocator& alloc) 
+			: data_(other.size_, alloc), size_(other.size_) 
 		{ 
 			std::uninitialized_copy_n(		// Copies count elements from a range beginning at first to an uninitialized memory area beginning
 				other.data_.GetAddress(),	// range beginning at first
@@ -88,7 +132,10 @@ class Vector {
 			); 
 		}
 
-		Vector(Vector&& other) noexcept { Swap(other); }
+		Vector(Vector&& other) noexcept 
+			: data_(std::move(other.data_))				// buffer and allocator are taken over, other is left empty
+			, size_(std::exchange(other.size_, 0))
+		{}
 
 		// --- Destructor -- 
 
@@ -107,7 +154,7 @@ class Vector {
 		Vector& operator=(const Vector& rhs) {			// assignment operator
 			if (this != &rhs) {							// checking for self-assignment
 				if (rhs.size_ > data_.Capacity()) {		// copy-and-swap
-					Vector rhs_copy(rhs);				// copy-and-swap
+					Vector rhs_copy(rhs, GetAllocator());	// copy-and-swap, keep own allocator
 					Swap(rhs_copy);						// copy-and-swap
 				}
 				else {	// Copy elements from rhs, creating new ones or deleting existing ones if necessary
@@ -145,14 +192,22 @@ class Vector {
 			return *this;
 		}
 
+		template <typename Expression, typename = decltype(std::declval<const Expression&>().EvaluateInto(std::declval<Vector&>()))>
+		Vector& operator=(const Expression& expression) {	// Lazy expressions (vector_expression.h) write straight into this buffer
+			expression.EvaluateInto(*this);
+			return *this;
+		}
+
 		// --- "std::vector"-like functions ---
 
 		size_t Size()     const noexcept { return size_; }				// Get vector size
 		size_t Capacity() const noexcept { return data_.Capacity(); }	// Get vector capacity
 
+		const Allocator& GetAllocator() const noexcept { return data_.GetAllocator(); }	// Get allocator the raw memory comes from
+
 		void Reserve(size_t new_capacity) {								// Reserve raw memory
 			if (new_capacity <= data_.Capacity()) { return; }
-			RawMemory<T> new_data(new_capacity);
+			RawMemory<T, Allocator> new_data(new_capacity, GetAllocator());
 
 			// should move elements unless their move constructor throws exceptions or they do not have a copy constructor
 
@@ -209,13 +264,19 @@ class Vector {
 			}
 		}
 
+		void Truncate(size_t new_size) noexcept {	// Drop the tail in one destroy pass, needs no default constructor unlike Resize
+			if (new_size >= size_) { return; }
+			std::destroy_n(data_.GetAddress() + new_size, size_ - new_size);
+			size_ = new_size;
+		}
+
 		template <typename... Args>
 		T& EmplaceBack(Args&&... args) {
 			T* result = nullptr;
 			int size_factor = 2; // raw memory increase factor if necessary
 
 			if (size_ == Capacity()) {
-				RawMemory<T> new_data(size_ == 0 ? 1 : size_ * size_factor);
+				RawMemory<T, Allocator> new_data(size_ == 0 ? 1 : size_ * size_factor, GetAllocator());
 				result = new(new_data + size_) T(std::forward<Args>(args)...);
 
 				// should move elements unless their move constructor throws exceptions or they do not have a copy constructor
@@ -264,7 +325,7 @@ class Vector {
 			int size_factor = 2; // raw memory increase factor if necessary
 
 			if (size_ == Capacity()) {
-				RawMemory<T> new_data(size_ == 0 ? 1 : size_ * size_factor);
+				RawMemory<T, Allocator> new_data(size_ == 0 ? 1 : size_ * size_factor, GetAllocator());
 				result = new(new_data + offset) T(std::forward<Args>(args)...);
 
 				// should move elements unless their move constructor throws exceptions or they do not have a copy constructor
@@ -358,8 +419,73 @@ class Vector {
 		const T* cbegin() const noexcept { return begin()                   ; } // getting a const iterator at the beginning of the vector
 		const T* cend()   const noexcept { return end()                     ; } // getting a const iterator at the end of the vector
 
+		// --- Views ---
+
+		Span<T>       Subspan(size_t offset, size_t count = Span<T>::NPOS)       noexcept { return AsSpan().Subspan(offset, count); }	// Slice without copying
+		Span<const T> Subspan(size_t offset, size_t count = Span<T>::NPOS) const noexcept { return AsSpan().Subspan(offset, count); }
+
+		Span<T>       AsSpan()       noexcept { return Span<T>(data_.GetAddress(), size_)      ; }
+		Span<const T> AsSpan() const noexcept { return Span<const T>(data_.GetAddress(), size_); }
+
+		// --- Hashing ---
+
+		uint64_t Hash(uint64_t seed = 0) const noexcept {	// Equal vectors hash equal, usable as deduplication keys
+			if constexpr (IS_BITWISE_COMPARABLE<T>) {	// equal values have equal bytes - hash the buffer at once
+				return HashBytes(data_.GetAddress(), size_ * sizeof(T), seed);
+			}
+			else {
+				uint64_t hash = HashCombine(seed, size_);
+				for (const T& value : *this) { hash = HashCombine(hash, std::hash<T>{}(value)); }
+				return hash;
+			}
+		}
+
 	private:
 
-		RawMemory<T> data_;	// Allocated raw memory
+		RawMemory<T, Allocator> data_;	// Allocated raw memory
 		size_t size_ = 0;
-};
\ No newline at end of file
+};
+
+// --- Comparison operators ---
+
+template <typename T, typename Allocator>
+bool operator==(const Vector<T, Allocator>& lhs, const Vector<T, Allocator>& rhs) {
+	if (lhs.Size() != rhs.Size()) { return false; }
+	if constexpr (IS_BITWISE_COMPARABLE<T>) {	// equality is bitwise; other types go through their own operator==
+		return lhs.Size() == 0 || std::memcmp(lhs.begin(), rhs.begin(), lhs.Size() * sizeof(T)) == 0;
+	}
+	else {
+		return std::equal(lhs.begin(), lhs.end(), rhs.begin());
+	}
+}
+
+template <typename T, typename Allocator>
+bool operator<(const Vector<T, Allocator>& lhs, const Vector<T, Allocator>& rhs) {	// Lexicographical
+	constexpr bool bytewise = std::is_same_v<T, unsigned char> || std::is_same_v<T, std::byte>
+		|| (std::is_same_v<T, char> && std::is_unsigned_v<char>);
+	if constexpr (bytewise) {		// memcmp order is unsigned byte order
+		size_t common = std::min(lhs.Size(), rhs.Size());
+		int order = common == 0 ? 0 : std::memcmp(lhs.begin(), rhs.begin(), common);
+		return order != 0 ? order < 0 : lhs.Size() < rhs.Size();
+	}
+	else {
+		return std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+	}
+}
+
+template <typename T, typename Allocator>
+bool operator!=(const Vector<T, Allocator>& lhs, const Vector<T, Allocator>& rhs) { return !(lhs == rhs); }
+
+template <typename T, typename Allocator>
+bool operator>(const Vector<T, Allocator>& lhs, const Vector<T, Allocator>& rhs) { return rhs < lhs; }
+
+template <typename T, typename Allocator>
+bool operator<=(const Vector<T, Allocator>& lhs, const Vector<T, Allocator>& rhs) { return !(rhs < lhs); }
+
+template <typename T, typename Allocator>
+bool operator>=(const Vector<T, Allocator>& lhs, const Vector<T, Allocator>& rhs) { return !(lhs < rhs); }
+
+template <typename T, typename Allocator>
+struct std::hash<Vector<T, Allocator>> {	// std::unordered_set<Vector<T>> and friends
+	size_t operator()(const Vector<T, Allocator>& vector) const noexcept { return static_cast<size_t>(vector.Hash()); }
+};
@@ -0,0 +1,319 @@
+#pragma once
+
+#include "vector.h"
+#include "simd.h"
+
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+// Expression templates for Vector<float>, Vector<double> and Vector<int32_t>:
+// `a = b * c + d` builds a tree of lightweight nodes and is evaluated in one pass over the data.
+// Evaluation goes chunk by chunk, intermediate results live in stack buffers that stay in L1,
+// so nothing is allocated unless the destination itself has to grow.
+
+enum class ArithmeticOp {
+	ADD,
+	SUB,
+	MUL,
+	DIV
+};
+
+namespace vector_expression_detail {
+
+	inline constexpr size_t CHUNK = 256;								// Elements per evaluation step
+	inline constexpr size_t ANY_SIZE = std::numeric_limits<size_t>::max();	// Size of a broadcast scalar
+
+	template <typename T>
+	inline constexpr bool IS_SIMD_ELEMENT = std::is_same_v<T, float> || std::is_same_v<T, double> || std::is_same_v<T, int32_t>;
+
+	template <ArithmeticOp OP, typename T>
+	T ApplyOne(T a, T b) noexcept {
+		if constexpr (OP == ArithmeticOp::ADD) { return a + b; }
+		if constexpr (OP == ArithmeticOp::SUB) { return a - b; }
+		if constexpr (OP == ArithmeticOp::MUL) { return a * b; }
+		if constexpr (OP == ArithmeticOp::DIV) { return a / b; }
+	}
+
+	template <ArithmeticOp OP, typename T>
+	void ScalarKernel(const T* a, const T* b, T* out, size_t count) noexcept {
+		for (size_t i = 0; i < count; ++i) { out[i] = ApplyOne<OP>(a[i], b[i]); }
+	}
+
+#if VECTOR_SIMD_X86
+
+	template <typename T> struct Avx2;
+
+	template <> struct Avx2<float> {
+		using Register = __m256;
+		static constexpr size_t WIDTH = 8;
+		SIMD_INLINE_AVX2 static Register Load(const float* p) noexcept { return _mm256_loadu_ps(p); }
+		SIMD_INLINE_AVX2 static void Store(float* p, Register r) noexcept { _mm256_storeu_ps(p, r); }
+		SIMD_INLINE_AVX2 static Register Add(Register a, Register b) noexcept { return _mm256_add_ps(a, b); }
+		SIMD_INLINE_AVX2 static Register Sub(Register a, Register b) noexcept { return _mm256_sub_ps(a, b); }
+		SIMD_INLINE_AVX2 static Register Mul(Register a, Register b) noexcept { return _mm256_mul_ps(a, b); }
+		SIMD_INLINE_AVX2 static Register Div(Register a, Register b) noexcept { return _mm256_div_ps(a, b); }
+	};
+
+	template <> struct Avx2<double> {
+		using Register = __m256d;
+		static constexpr size_t WIDTH = 4;
+		SIMD_INLINE_AVX2 static Register Load(const double* p) noexcept { return _mm256_loadu_pd(p); }
+		SIMD_INLINE_AVX2 static void Store(double* p, Register r) noexcept { _mm256_storeu_pd(p, r); }
+		SIMD_INLINE_AVX2 static Register Add(Register a, Register b) noexcept { return _mm256_add_pd(a, b); }
+		SIMD_INLINE_AVX2 static Register Sub(Register a, Register b) noexcept { return _mm256_sub_pd(a, b); }
+		SIMD_INLINE_AVX2 static Register Mul(Register a, Register b) noexcept { return _mm256_mul_pd(a, b); }
+		SIMD_INLINE_AVX2 static Register Div(Register a, Register b) noexcept { return _mm256_div_pd(a, b); }
+	};
+
+	template <> struct Avx2<int32_t> {	// no Div - there is no packed integer division, dispatching one fails to compile
+		using Register = __m256i;
+		static constexpr size_t WIDTH = 8;
+		SIMD_INLINE_AVX2 static Register Load(const int32_t* p) noexcept { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+		SIMD_INLINE_AVX2 static void Store(int32_t* p, Register r) noexcept { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), r); }
+		SIMD_INLINE_AVX2 static Register Add(Register a, Register b) noexcept { return _mm256_add_epi32(a, b); }
+		SIMD_INLINE_AVX2 static Register Sub(Register a, Register b) noexcept { return _mm256_sub_epi32(a, b); }
+		SIMD_INLINE_AVX2 static Register Mul(Register a, Register b) noexcept { return _mm256_mullo_epi32(a, b); }
+	};
+
+	template <typename T> struct Avx512;
+
+	template <> struct Avx512<float> {
+		using Register = __m512;
+		static constexpr size_t WIDTH = 16;
+		SIMD_INLINE_AVX512 static Register Load(const float* p) noexcept { return _mm512_loadu_ps(p); }
+		SIMD_INLINE_AVX512 static void Store(float* p, Register r) noexcept { _mm512_storeu_ps(p, r); }
+		SIMD_INLINE_AVX512 static Register Add(Register a, Register b) noexcept { return _mm512_add_ps(a, b); }
+		SIMD_INLINE_AVX512 static Register Sub(Register a, Register b) noexcept { return _mm512_sub_ps(a, b); }
+		SIMD_INLINE_AVX512 static Register Mul(Register a, Register b) noexcept { return _mm512_mul_ps(a, b); }
+		SIMD_INLINE_AVX512 static Register Div(Register a, Register b) noexcept { return _mm512_div_ps(a, b); }
+	};
+
+	template <> struct Avx512<double> {
+		using Register = __m512d;
+		static constexpr size_t WIDTH = 8;
+		SIMD_INLINE_AVX512 static Register Load(const double* p) noexcept { return _mm512_loadu_pd(p); }
+		SIMD_INLINE_AVX512 static void Store(double* p, Register r) noexcept { _mm512_storeu_pd(p, r); }
+		SIMD_INLINE_AVX512 static Register Add(Register a, Register b) noexcept { return _mm512_add_pd(a, b); }
+		SIMD_INLINE_AVX512 static Register Sub(Register a, Register b) noexcept { return _mm512_sub_pd(a, b); }
+		SIMD_INLINE_AVX512 static Register Mul(Register a, Register b) noexcept { return _mm512_mul_pd(a, b); }
+		SIMD_INLINE_AVX512 static Register Div(Register a, Register b) noexcept { return _mm512_div_pd(a, b); }
+	};
+
+	template <> struct Avx512<int32_t> {	// no Div - there is no packed integer division, dispatching one fails to compile
+		using Register = __m512i;
+		static constexpr size_t WIDTH = 16;
+		SIMD_INLINE_AVX512 static Register Load(const int32_t* p) noexcept { return _mm512_loadu_si512(p); }
+		SIMD_INLINE_AVX512 static void Store(int32_t* p, Register r) noexcept { _mm512_storeu_si512(p, r); }
+		SIMD_INLINE_AVX512 static Register Add(Register a, Register b) noexcept { return _mm512_add_epi32(a, b); }
+		SIMD_INLINE_AVX512 static Register Sub(Register a, Register b) noexcept { return _mm512_sub_epi32(a, b); }
+		SIMD_INLINE_AVX512 static Register Mul(Register a, Register b) noexcept { return _mm512_mullo_epi32(a, b); }
+	};
+
+	template <ArithmeticOp OP, typename T>
+	SIMD_TARGET_AVX2 void Avx2Kernel(const T* a, const T* b, T* out, size_t count) noexcept {
+		using Isa = Avx2<T>;
+		size_t i = 0;
+		for (; i + Isa::WIDTH <= count; i += Isa::WIDTH) {
+			typename Isa::Register x = Isa::Load(a + i);
+			typename Isa::Register y = Isa::Load(b + i);
+			if constexpr (OP == ArithmeticOp::ADD) { Isa::Store(out + i, Isa::Add(x, y)); }
+			if constexpr (OP == ArithmeticOp::SUB) { Isa::Store(out + i, Isa::Sub(x, y)); }
+			if constexpr (OP == ArithmeticOp::MUL) { Isa::Store(out + i, Isa::Mul(x, y)); }
+			if constexpr (OP == ArithmeticOp::DIV) { Isa::Store(out + i, Isa::Div(x, y)); }
+		}
+		for (; i < count; ++i) { out[i] = ApplyOne<OP>(a[i], b[i]); }
+	}
+
+	template <ArithmeticOp OP, typename T>
+	SIMD_TARGET_AVX512 void Avx512Kernel(const T* a, const T* b, T* out, size_t count) noexcept {
+		using Isa = Avx512<T>;
+		size_t i = 0;
+		for (; i + Isa::WIDTH <= count; i += Isa::WIDTH) {
+			typename Isa::Register x = Isa::Load(a + i);
+			typename Isa::Register y = Isa::Load(b + i);
+			if constexpr (OP == ArithmeticOp::ADD) { Isa::Store(out + i, Isa::Add(x, y)); }
+			if constexpr (OP == ArithmeticOp::SUB) { Isa::Store(out + i, Isa::Sub(x, y)); }
+			if constexpr (OP == ArithmeticOp::MUL) { Isa::Store(out + i, Isa::Mul(x, y)); }
+			if constexpr (OP == ArithmeticOp::DIV) { Isa::Store(out + i, Isa::Div(x, y)); }
+		}
+		for (; i < count; ++i) { out[i] = ApplyOne<OP>(a[i], b[i]); }
+	}
+
+#endif
+
+	template <ArithmeticOp OP, typename T>
+	void Apply(const T* a, const T* b, T* out, size_t count) noexcept {	// Elementwise, out may alias a or b
+#if VECTOR_SIMD_X86
+		constexpr bool vectorizable = OP != ArithmeticOp::DIV || !std::is_integral_v<T>;
+		if constexpr (vectorizable) {
+			switch (ActiveSimdLevel()) {
+				case SimdLevel::AVX512: Avx512Kernel<OP>(a, b, out, count); return;
+				case SimdLevel::AVX2:   Avx2Kernel<OP>(a, b, out, count);   return;
+				case SimdLevel::SSE42:
+				case SimdLevel::SCALAR: break;
+			}
+		}
+#endif
+		ScalarKernel<OP>(a, b, out, count);
+	}
+
+	// --- Expression nodes: Chunk() returns a pointer to count evaluated elements, either in place or in scratch ---
+
+	template <typename T>
+	class VectorOperand {
+
+		public:
+
+			using Value = T;
+
+			template <typename Allocator>
+			explicit VectorOperand(const Vector<T, Allocator>& vector) noexcept : data_(vector.begin()), size_(vector.Size()) {}
+
+			size_t Size() const noexcept { return size_; }
+			const T* Chunk(size_t offset, size_t, T*) const noexcept { return data_ + offset; }	// no copy
+
+		private:
+
+			const T* data_;
+			size_t size_;
+	};
+
+	template <typename T>
+	class ScalarOperand {
+
+		public:
+
+			using Value = T;
+
+			explicit ScalarOperand(T value) noexcept : value_(value) {}
+
+			size_t Size() const noexcept { return ANY_SIZE; }
+			const T* Chunk(size_t, size_t count, T* scratch) const noexcept {
+				for (size_t i = 0; i < count; ++i) { scratch[i] = value_; }
+				return scratch;
+			}
+
+		private:
+
+			T value_;
+	};
+
+	template <ArithmeticOp OP, typename Left, typename Right>
+	class BinaryExpression {
+
+		public:
+
+			using Value = typename Left::Value;
+
+			BinaryExpression(Left left, Right right) noexcept
+				: left_(left)
+				, right_(right)
+			{
+				assert(left_.Size() == ANY_SIZE || right_.Size() == ANY_SIZE || left_.Size() == right_.Size());
+			}
+
+			size_t Size() const noexcept { return left_.Size() != ANY_SIZE ? left_.Size() : right_.Size(); }
+
+			const Value* Chunk(size_t offset, size_t count, Value* out) const noexcept {
+				Value left_scratch[CHUNK];
+				Value right_scratch[CHUNK];
+				const Value* a = left_.Chunk(offset, count, left_scratch);
+				const Value* b = right_.Chunk(offset, count, right_scratch);
+				Apply<OP>(a, b, out, count);
+				return out;
+			}
+
+			template <typename Allocator>
+			void EvaluateInto(Vector<Value, Allocator>& destination) const {	// Reuses existing capacity, elementwise so destination may be an operand
+				size_t size = Size();
+				assert(size != ANY_SIZE);
+				if (destination.Size() != size) { destination.Resize(size); }
+				Value* out = destination.begin();
+				for (size_t offset = 0; offset < size; offset += CHUNK) {
+					size_t count = size - offset < CHUNK ? size - offset : CHUNK;
+					Chunk(offset, count, out + offset);
+				}
+			}
+
+		private:
+
+			Left left_;
+			Right right_;
+	};
+
+	template <typename T>
+	struct IsExpression : std::false_type {};
+	template <ArithmeticOp OP, typename Left, typename Right>
+	struct IsExpression<BinaryExpression<OP, Left, Right>> : std::true_type {};
+
+	template <typename T>
+	struct IsSimdVector : std::false_type {};
+	template <typename T, typename Allocator>
+	struct IsSimdVector<Vector<T, Allocator>> : std::bool_constant<IS_SIMD_ELEMENT<T>> {};	// any allocator, arena-backed vectors included
+
+	template <typename T>
+	inline constexpr bool IS_OPERAND = IsExpression<T>::value || IsSimdVector<T>::value;
+
+	template <typename T> struct ValueOf { using Type = void; };	// void - not an operand
+	template <ArithmeticOp OP, typename Left, typename Right>
+	struct ValueOf<BinaryExpression<OP, Left, Right>> { using Type = typename BinaryExpression<OP, Left, Right>::Value; };
+	template <typename T, typename Allocator>
+	struct ValueOf<Vector<T, Allocator>> { using Type = T; };
+
+	template <typename Value, typename S>
+	constexpr bool IsLosslessScalar() noexcept {	// Every S converts to Value exactly, so `Vector<int32_t> * 2.5` does not compile
+		if constexpr (!std::is_arithmetic_v<Value> || !std::is_arithmetic_v<S>) { return false; }
+		else if constexpr (std::is_same_v<S, Value>) { return true; }
+		else if constexpr (std::is_integral_v<Value> && std::is_integral_v<S>) {
+			using ValueLimits = std::numeric_limits<Value>;
+			using ScalarLimits = std::numeric_limits<S>;
+			return (!ScalarLimits::is_signed || ValueLimits::is_signed) && ScalarLimits::digits <= ValueLimits::digits;
+		}
+		else if constexpr (std::is_floating_point_v<Value>) {	// integers up to the mantissa width, floats no wider than Value
+			return std::numeric_limits<S>::digits <= std::numeric_limits<Value>::digits;
+		}
+		else { return false; }									// floating point into an integer vector
+	}
+
+	template <typename Value, typename T>
+	auto MakeOperand(const T& operand) noexcept {
+		if constexpr (IsSimdVector<T>::value)     { return VectorOperand<Value>(operand); }
+		else if constexpr (IsExpression<T>::value) { return operand; }
+		else                                      { return ScalarOperand<Value>(static_cast<Value>(operand)); }	// lossless, see ENABLE_OPERATOR
+	}
+
+	template <ArithmeticOp OP, typename L, typename R>
+	auto MakeExpression(const L& left, const R& right) noexcept {
+		using Value = typename ValueOf<std::conditional_t<IS_OPERAND<L>, L, R>>::Type;
+		auto l = MakeOperand<Value>(left);
+		auto r = MakeOperand<Value>(right);
+		return BinaryExpression<OP, decltype(l), decltype(r)>(l, r);
+	}
+
+	template <typename L, typename R>
+	inline constexpr bool ENABLE_OPERATOR = (IS_OPERAND<L> && (IS_OPERAND<R> || IsLosslessScalar<typename ValueOf<L>::Type, R>()))
+		|| (IsLosslessScalar<typename ValueOf<R>::Type, L>() && IS_OPERAND<R>);
+
+}  // namespace vector_expression_detail
+
+// Expressions keep pointers to their Vector operands, evaluate them before the operands go away
+
+template <typename L, typename R, typename = std::enable_if_t<vector_expression_detail::ENABLE_OPERATOR<L, R>>>
+auto operator+(const L& left, const R& right) noexcept { return vector_expression_detail::MakeExpression<ArithmeticOp::ADD>(left, right); }
+
+template <typename L, typename R, typename = std::enable_if_t<vector_expression_detail::ENABLE_OPERATOR<L, R>>>
+auto operator-(const L& left, const R& right) noexcept { return vector_expression_detail::MakeExpression<ArithmeticOp::SUB>(left, right); }
+
+template <typename L, typename R, typename = std::enable_if_t<vector_expression_detail::ENABLE_OPERATOR<L, R>>>
+auto operator*(const L& left, const R& right) noexcept { return vector_expression_detail::MakeExpression<ArithmeticOp::MUL>(left, right); }
+
+template <typename L, typename R, typename = std::enable_if_t<vector_expression_detail::ENABLE_OPERATOR<L, R>>>
+auto operator/(const L& left, const R& right) noexcept { return vector_expression_detail::MakeExpression<ArithmeticOp::DIV>(left, right); }
+
+template <typename Expression, typename = std::enable_if_t<vector_expression_detail::IsExpression<Expression>::value>>
+Vector<typename Expression::Value> Evaluate(const Expression& expression) {	// Materialize into a new Vector
+	Vector<typename Expression::Value> result;
+	expression.EvaluateInto(result);
+	return result;
+}